@@ -0,0 +1,983 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "analysis.h"
+#include "eca.h"
+#include "hashlife.h"
+#include "lut.h"
+#include "options.h"
+#include "packed.h"
+#include "palette.h"
+#include "png.h"
+#include "rng.h"
+#include "simd.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Throughput of the generators, initialisers, palettes, and PNG encoder,
+ * across a range of row widths, of the lookup table kernels against the
+ * per-cell loops, of analysis records, which are also checked against
+ * counting cell by cell, and of HashLife jumps, which are also checked
+ * against stepping the row.
+ *
+ * Each case is first called until a run of calls takes at least `min_time`
+ * seconds, which also warms it up. The fastest of `repetitions` runs of that
+ * many calls is reported.
+ */
+
+static const char* bench_help_text = (
+"Usage: bench [-f csv|json] [-r REPETITIONS] [-t SECONDS] [-W WIDTH]\n"
+"\n"
+"Times every generator, initialiser, palette, the random bit lanes, the PNG\n"
+"encoder, the lookup tables against the per-cell loops, the analysis of rows,\n"
+"and HashLife jumps, the last two failing the run if they do not match.\n"
+"\n"
+"  -f FORMAT             Output format {csv, json}, Default: csv\n"
+"  -r REPETITIONS        Timed runs of each case, Default: 5\n"
+"  -t SECONDS            Shortest run, Default: 0.01\n"
+"  -W WIDTH              Widest row, Default: 16777216\n"
+"  -h                    Display this text and exit.\n"
+);
+
+static const size_t widths[] = {
+	64, 1024, 16384, 262144, 4194304, 16777216
+};
+
+static const uint8_t rules[] = {30, 90, 110};
+
+/* rules whose cells rarely match their neighbours, so per-cell loops branch */
+static const size_t lut_width = 16384;
+static const uint8_t lut_rules[] = {30, 45, 105};
+
+/* rows measured against counting cell by cell, from sparse to full */
+static const double analysis_densities[] = {
+	0.05, 0.3, 0.5, 0.7, 0.9, 0.97, 0.99, 1.0
+};
+
+/* pixels per PNG image, split into rows of each width */
+static const size_t png_pixels = 1 << 20;
+
+/* lanes are seeded cell by cell, and are rarely wider than this */
+static const size_t rng_max_width = 16384;
+
+/*
+ * HashLife jumps a row which is not a power of two wide, whose blocks do not
+ * line up from one copy of the row to the next, in tables of 1 MiB
+ */
+static const size_t hashlife_width = 1000;
+static const uint64_t hashlife_generations = 1000000;
+static const size_t hashlife_memory = 1 << 20;
+static const uint8_t hashlife_rules[] = {30, 73, 90, 110};
+
+enum OutputFormat {
+	BENCH_CSV  = 0,
+	BENCH_JSON = 1
+};
+
+struct Bench {
+	enum OutputFormat format;
+	int repetitions;
+	double min_time;
+	size_t max_width;
+	size_t result_count;
+};
+
+struct Result {
+	const char* group;
+	const char* name;
+	enum Mode mode;
+	int rule; /* -1 where there is none */
+	size_t width;
+	size_t cells; /* per call */
+	size_t bytes; /* per call */
+	uint64_t calls;
+	double seconds; /* per call */
+};
+
+/* makes one call of a case */
+typedef void case_fn(void* context);
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + (ts.tv_nsec * 1e-9);
+}
+
+static double time_calls(case_fn* fn, void* context, uint64_t calls) {
+	double start = now();
+	for (uint64_t i = 0; i < calls; ++i) {
+		fn(context);
+	}
+
+	return now() - start;
+}
+
+static void measure(
+	const struct Bench* bench, struct Result* result,
+	case_fn* fn, void* context
+) {
+	uint64_t calls = 1;
+	double elapsed = time_calls(fn, context, calls);
+
+	while (elapsed < bench->min_time) {
+		calls *= 2;
+		elapsed = time_calls(fn, context, calls);
+	}
+
+	double best = elapsed;
+	for (int i = 0; i < bench->repetitions; ++i) {
+		elapsed = time_calls(fn, context, calls);
+		if (elapsed < best) {
+			best = elapsed;
+		}
+	}
+
+	result->calls = calls;
+	result->seconds = best / calls;
+}
+
+static void print_result(struct Bench* bench, const struct Result* result) {
+	double ns_per_cell = (result->seconds * 1e9) / result->cells;
+	double cells_per_second = result->cells / result->seconds;
+	double bytes_per_second = result->bytes / result->seconds;
+
+	/* initialisers have no mode, and only generators have a rule */
+	const char* mode = "";
+	if (result->mode != MODE_UNKNOWN) {
+		mode = modestr(result->mode);
+	}
+
+	char rule[12] = "";
+	if (result->rule >= 0) {
+		snprintf(rule, sizeof(rule), "%d", result->rule);
+	}
+
+	if (bench->format == BENCH_JSON) {
+		printf(
+			"%s\n  {\"group\": \"%s\", \"name\": \"%s\", \"mode\": %s%s%s, "
+			"\"rule\": %s, \"width\": %zu, \"calls\": %llu, "
+			"\"ns_per_cell\": %.6g, \"cells_per_second\": %.6g, "
+			"\"bytes_per_second\": %.6g}",
+			(bench->result_count == 0) ? "[" : ",",
+			result->group, result->name,
+			(*mode != 0) ? "\"" : "", (*mode != 0) ? mode : "null",
+			(*mode != 0) ? "\"" : "",
+			(result->rule >= 0) ? rule : "null", result->width,
+			(unsigned long long)result->calls,
+			ns_per_cell, cells_per_second, bytes_per_second
+		);
+	} else {
+		if (bench->result_count == 0) {
+			printf(
+				"group,name,mode,rule,width,calls,"
+				"ns_per_cell,cells_per_second,bytes_per_second\n"
+			);
+		}
+		printf(
+			"%s,%s,%s,%s,%zu,%llu,%.6g,%.6g,%.6g\n",
+			result->group, result->name, mode, rule,
+			result->width, (unsigned long long)result->calls,
+			ns_per_cell, cells_per_second, bytes_per_second
+		);
+	}
+
+	fflush(stdout);
+	bench->result_count += 1;
+}
+
+/* byte layout *************************************************************/
+struct ByteCase {
+	eca_gen_fn* gen_fn;
+	eca_init_fn* init_fn;
+	uint8_t* rows[2];
+	size_t width;
+	uint8_t rules[3];
+};
+
+static void byte_generate(void* context) {
+	struct ByteCase* c = context;
+	size_t row_size = c->width * 3;
+
+	/* generators only write activated cells, as in `render` */
+	memset(c->rows[1], ECA_OFF, row_size);
+	c->gen_fn(c->rows[1], c->rows[0], c->width, 3, c->rules);
+
+	uint8_t* tmp = c->rows[0];
+	c->rows[0] = c->rows[1];
+	c->rows[1] = tmp;
+}
+
+static void byte_initialise(void* context) {
+	struct ByteCase* c = context;
+	c->init_fn(c->rows[0], c->width, 3);
+}
+
+static const struct {
+	const char* name;
+	enum Mode mode;
+	eca_gen_fn* gen_fn;
+} byte_kernels[] = {
+	{"eca_generate", MODE_STANDARD, eca_generate},
+	{"eca_generate_split", MODE_SPLIT, eca_generate_split},
+	{
+		"eca_generate_directional", MODE_DIRECTIONAL,
+		eca_generate_directional
+	},
+	{"eca_generate_lut", MODE_STANDARD, eca_generate_lut},
+	{"eca_generate_split_lut", MODE_SPLIT, eca_generate_split_lut},
+	{
+		"eca_generate_directional_lut", MODE_DIRECTIONAL,
+		eca_generate_directional_lut
+	}
+};
+
+static const struct {
+	enum Mode mode;
+	const char* cell_name;
+	eca_gen_fn* cell_fn;
+	const char* lut_name;
+	eca_gen_fn* lut_fn;
+} lut_kernels[] = {
+	{
+		MODE_STANDARD, "eca_generate", eca_generate,
+		"eca_generate_lut", eca_generate_lut
+	},
+	{
+		MODE_SPLIT, "eca_generate_split", eca_generate_split,
+		"eca_generate_split_lut", eca_generate_split_lut
+	},
+	{
+		MODE_DIRECTIONAL, "eca_generate_directional",
+		eca_generate_directional,
+		"eca_generate_directional_lut", eca_generate_directional_lut
+	}
+};
+
+static const struct {
+	const char* name;
+	eca_init_fn* init_fn;
+} byte_initialisers[] = {
+	{"eca_initialise",           eca_initialise},
+	{"eca_initialise_alternate", eca_initialise_alternate},
+	{"eca_initialise_random",    eca_initialise_random}
+};
+
+/* returns the seconds per call */
+static double run_byte_generate(
+	struct Bench* bench, struct ByteCase* c, const char* group,
+	const char* name, enum Mode mode, int rule
+) {
+	struct Result result = {
+		.group = group,
+		.name = name,
+		.mode = mode,
+		.rule = rule,
+		.width = c->width,
+		.cells = c->width,
+		.bytes = c->width * 3
+	};
+
+	eca_initialise_random(c->rows[0], c->width, 3);
+	measure(bench, &result, byte_generate, c);
+	print_result(bench, &result);
+
+	return result.seconds;
+}
+
+static bool bench_bytes(struct Bench* bench, size_t width) {
+	struct ByteCase c = {
+		.rows = {malloc(width * 3), malloc(width * 3)},
+		.width = width
+	};
+	if (c.rows[0] == NULL || c.rows[1] == NULL) {
+		free(c.rows[1]);
+		free(c.rows[0]);
+		return false;
+	}
+
+	char name[64];
+	size_t kernel_count = sizeof(byte_kernels) / sizeof(*byte_kernels);
+
+	for (size_t r = 0; r < sizeof(rules); ++r) {
+		memset(c.rules, rules[r], sizeof(c.rules));
+		eca_lut_prepare(c.rules, 3);
+
+		for (size_t k = 0; k < kernel_count; ++k) {
+			enum Mode mode = byte_kernels[k].mode;
+
+			c.gen_fn = byte_kernels[k].gen_fn;
+			run_byte_generate(
+				bench, &c, "generate", byte_kernels[k].name, mode, rules[r]
+			);
+
+			/* and the vectorised kernel the engine would choose instead */
+			eca_gen_fn* simd_fn = eca_simd_select(c.gen_fn);
+			if (simd_fn != c.gen_fn) {
+				snprintf(
+					name, sizeof(name), "%s_%s",
+					byte_kernels[k].name, eca_simd_name()
+				);
+				c.gen_fn = simd_fn;
+				run_byte_generate(
+					bench, &c, "generate", name, mode, rules[r]
+				);
+			}
+		}
+
+		c.gen_fn = eca_rule_kernel(rules[r]);
+		run_byte_generate(
+			bench, &c, "generate", "eca_rule_kernel", MODE_STANDARD,
+			rules[r]
+		);
+	}
+
+	size_t init_count = sizeof(byte_initialisers) / sizeof(*byte_initialisers);
+	for (size_t i = 0; i < init_count; ++i) {
+		struct Result result = {
+			.group = "initialise",
+			.name = byte_initialisers[i].name,
+			.mode = MODE_UNKNOWN,
+			.rule = -1,
+			.width = width,
+			.cells = width,
+			.bytes = width * 3
+		};
+
+		c.init_fn = byte_initialisers[i].init_fn;
+		measure(bench, &result, byte_initialise, &c);
+		print_result(bench, &result);
+	}
+
+	free(c.rows[1]);
+	free(c.rows[0]);
+	return true;
+}
+
+/* lookup tables **********************************************************/
+/*
+ * Each per-cell kernel against the table driven kernel for the same mode,
+ * warning if the table is slower.
+ */
+static bool bench_lut(struct Bench* bench, uint8_t rule) {
+	size_t width = lut_width;
+	struct ByteCase c = {
+		.rows = {malloc(width * 3), malloc(width * 3)},
+		.width = width,
+		.rules = {rule, rule, rule}
+	};
+	if (c.rows[0] == NULL || c.rows[1] == NULL) {
+		free(c.rows[1]);
+		free(c.rows[0]);
+		return false;
+	}
+
+	eca_lut_prepare(c.rules, 3);
+
+	for (size_t k = 0; k < sizeof(lut_kernels) / sizeof(*lut_kernels); ++k) {
+		enum Mode mode = lut_kernels[k].mode;
+
+		c.gen_fn = lut_kernels[k].cell_fn;
+		double cell_seconds = run_byte_generate(
+			bench, &c, "lut", lut_kernels[k].cell_name, mode, rule
+		);
+
+		c.gen_fn = lut_kernels[k].lut_fn;
+		double lut_seconds = run_byte_generate(
+			bench, &c, "lut", lut_kernels[k].lut_name, mode, rule
+		);
+
+		if (lut_seconds > cell_seconds) {
+			fprintf(
+				stderr, "warning: %s is slower than %s for rule %d\n",
+				lut_kernels[k].lut_name, lut_kernels[k].cell_name, rule
+			);
+		}
+	}
+
+	free(c.rows[1]);
+	free(c.rows[0]);
+	return true;
+}
+
+/* packed layout ***********************************************************/
+struct PackedCase {
+	eca_packed_gen_fn* gen_fn;
+	eca_packed_init_fn* init_fn;
+	const struct Palette* palette;
+	uint64_t* rows[2];
+	uint8_t* pixels;
+	size_t width;
+	int plane_count;
+	uint8_t rules[3];
+};
+
+static void packed_generate(void* context) {
+	struct PackedCase* c = context;
+	c->gen_fn(c->rows[1], c->rows[0], c->width, c->plane_count, c->rules);
+
+	uint64_t* tmp = c->rows[0];
+	c->rows[0] = c->rows[1];
+	c->rows[1] = tmp;
+}
+
+static void packed_initialise(void* context) {
+	struct PackedCase* c = context;
+	c->init_fn(c->rows[0], c->width, c->plane_count);
+}
+
+static void packed_colour(void* context) {
+	struct PackedCase* c = context;
+	palette_apply(c->palette, FORMAT_RGB, c->pixels, c->rows[0], c->width);
+}
+
+static const struct {
+	const char* name;
+	enum Mode mode;
+	int plane_count;
+	eca_packed_gen_fn* gen_fn;
+} packed_kernels[] = {
+	{
+		"eca_packed_generate", MODE_STANDARD,
+		ECA_PLANES_STANDARD, eca_packed_generate
+	},
+	{
+		"eca_packed_generate_split", MODE_SPLIT,
+		ECA_PLANES_SPLIT, eca_packed_generate_split
+	},
+	{
+		"eca_packed_generate_directional", MODE_DIRECTIONAL,
+		ECA_PLANES_DIRECTIONAL, eca_packed_generate_directional
+	}
+};
+
+/* a density that is not a power of two takes the most rounds to draw */
+static void packed_initialise_seeded(
+	uint64_t* dst, size_t width, int plane_count
+) {
+	size_t words = eca_packed_words(width);
+	eca_packed_initialise_seeded(dst, width, plane_count, 1, 0.3, 0, words);
+}
+
+static const struct {
+	const char* name;
+	eca_packed_init_fn* init_fn;
+} packed_initialisers[] = {
+	{"eca_packed_initialise",           eca_packed_initialise},
+	{"eca_packed_initialise_alternate", eca_packed_initialise_alternate},
+	{"eca_packed_initialise_random",    eca_packed_initialise_random},
+	{"eca_packed_initialise_seeded",    packed_initialise_seeded}
+};
+
+static bool bench_packed(struct Bench* bench, size_t width) {
+	size_t words = eca_packed_words(width);
+	size_t size = words * ECA_PLANES_DIRECTIONAL * sizeof(uint64_t);
+
+	struct PackedCase c = {
+		.rows = {malloc(size), malloc(size)},
+		.pixels = malloc(palette_row_size(FORMAT_RGB, width)),
+		.width = width
+	};
+
+	bool ok = c.rows[0] != NULL && c.rows[1] != NULL && c.pixels != NULL;
+	size_t kernel_count = sizeof(packed_kernels) / sizeof(*packed_kernels);
+
+	for (size_t r = 0; ok && r < sizeof(rules); ++r) {
+		memset(c.rules, rules[r], sizeof(c.rules));
+
+		for (size_t k = 0; k < kernel_count; ++k) {
+			c.gen_fn = packed_kernels[k].gen_fn;
+			c.plane_count = packed_kernels[k].plane_count;
+
+			struct Result result = {
+				.group = "generate",
+				.name = packed_kernels[k].name,
+				.mode = packed_kernels[k].mode,
+				.rule = rules[r],
+				.width = width,
+				.cells = width,
+				.bytes = words * c.plane_count * sizeof(uint64_t)
+			};
+
+			eca_packed_initialise_random(c.rows[0], width, c.plane_count);
+			measure(bench, &result, packed_generate, &c);
+			print_result(bench, &result);
+		}
+	}
+
+	size_t init_count = sizeof(packed_initialisers)
+	                  / sizeof(*packed_initialisers);
+	for (size_t i = 0; ok && i < init_count; ++i) {
+		struct Result result = {
+			.group = "initialise",
+			.name = packed_initialisers[i].name,
+			.mode = MODE_UNKNOWN,
+			.rule = -1,
+			.width = width,
+			.cells = width,
+			.bytes = words * sizeof(uint64_t)
+		};
+
+		c.init_fn = packed_initialisers[i].init_fn;
+		c.plane_count = ECA_PLANES_STANDARD;
+		measure(bench, &result, packed_initialise, &c);
+		print_result(bench, &result);
+	}
+
+	/* colouring a packed row into RGB pixels */
+	for (enum Mode mode = MODE_STANDARD; ok && mode < MODE_LIST_RULES; ++mode) {
+		struct Palette palette;
+		switch (mode) {
+			default:
+			case MODE_STANDARD:    palette_standard(&palette);    break;
+			case MODE_SPLIT:       palette_split(&palette);       break;
+			case MODE_DIRECTIONAL: palette_directional(&palette); break;
+		}
+
+		struct Result result = {
+			.group = "colour",
+			.name = "palette_apply",
+			.mode = mode,
+			.rule = -1,
+			.width = width,
+			.cells = width,
+			.bytes = palette_row_size(FORMAT_RGB, width)
+		};
+
+		c.palette = &palette;
+		eca_packed_initialise_random(c.rows[0], width, palette.plane_count);
+		measure(bench, &result, packed_colour, &c);
+		print_result(bench, &result);
+	}
+
+	free(c.pixels);
+	free(c.rows[1]);
+	free(c.rows[0]);
+	return ok;
+}
+
+/* random bits *************************************************************/
+struct RngCase {
+	struct RngLanes* lanes;
+	uint64_t word;
+};
+
+static void rng_generate(void* context) {
+	struct RngCase* c = context;
+	rng_lanes_generate(c->lanes, &c->word, 1, 1);
+}
+
+static bool bench_rng(struct Bench* bench, size_t width) {
+	if (width > rng_max_width) {
+		return true;
+	}
+
+	struct RngCase c = {rng_lanes_create(width, 30, 1), 0};
+	if (c.lanes == NULL) {
+		return false;
+	}
+
+	/* a generation of every lane, for one word of bits */
+	struct Result result = {
+		.group = "rng",
+		.name = "rng_lanes_generate",
+		.mode = MODE_STANDARD,
+		.rule = 30,
+		.width = width,
+		.cells = width * RNG_LANES,
+		.bytes = sizeof(c.word)
+	};
+
+	measure(bench, &result, rng_generate, &c);
+	print_result(bench, &result);
+
+	rng_lanes_free(c.lanes);
+	return true;
+}
+
+/* analysis ****************************************************************/
+struct AnalysisCase {
+	struct AnalysisWriter* analysis;
+	const uint8_t* row;
+};
+
+static void analysis_measure(void* context) {
+	struct AnalysisCase* c = context;
+	analysis_write_row(c->analysis, c->row);
+}
+
+/* a mono row with each cell activated with probability `density` */
+static void random_mono_row(
+	uint8_t* row, size_t width, double density, uint64_t* state
+) {
+	memset(row, 0, (width + 7) / 8);
+	for (size_t i = 0; i < width; ++i) {
+		/* xorshift64 */
+		*state ^= *state << 13;
+		*state ^= *state >> 7;
+		*state ^= *state << 17;
+
+		if ((*state >> 11) * 0x1p-53 < density) {
+			row[i / 8] |= 0x80 >> (i % 8);
+		}
+	}
+}
+
+/* the counts of `analysis.h`, one cell at a time */
+static void count_cells(
+	const uint8_t* row, size_t width, struct AnalysisRecord* record
+) {
+	memset(record, 0, sizeof(*record));
+
+	uint64_t length = 0;
+	for (size_t i = 0; i <= width; ++i) {
+		bool on = i < width && ((row[i / 8] >> (7 - (i % 8))) & 1) != 0;
+		if (on) {
+			record->ones += 1;
+			length += 1;
+		} else if (length > 0) {
+			record->runs += 1;
+			if (length > ANALYSIS_RUN_LENGTHS) {
+				record->longer_runs += 1;
+			} else {
+				record->run_lengths[length - 1] += 1;
+			}
+			length = 0;
+		}
+	}
+}
+
+/* the counts of binary records against counting cell by cell */
+static bool check_analysis(uint8_t* row, size_t width) {
+	size_t row_count = sizeof(analysis_densities)
+	                 / sizeof(*analysis_densities);
+
+	char filename[] = "/tmp/bench-analysis-XXXXXX";
+	int fd = mkstemp(filename);
+	if (fd < 0) {
+		return false;
+	}
+	close(fd);
+
+	struct AnalysisWriter* analysis = analysis_open(
+		filename, width, row_count, 0, 1, ANALYSIS_BINARY
+	);
+	bool ok = analysis != NULL;
+
+	uint64_t state = 0x9e3779b97f4a7c15ULL;
+	for (size_t n = 0; ok && n < row_count; ++n) {
+		random_mono_row(row, width, analysis_densities[n], &state);
+		ok = analysis_write_row(analysis, row);
+	}
+	ok = (analysis != NULL) && analysis_close(analysis) && ok;
+
+	FILE* file = fopen(filename, "rb");
+	state = 0x9e3779b97f4a7c15ULL;
+	for (size_t n = 0; ok && n < row_count; ++n) {
+		struct AnalysisRecord record;
+		struct AnalysisRecord expected;
+		random_mono_row(row, width, analysis_densities[n], &state);
+		count_cells(row, width, &expected);
+
+		ok = fread(&record, sizeof(record), 1, file) == 1
+		  && record.ones == expected.ones && record.runs == expected.runs
+		  && record.longer_runs == expected.longer_runs
+		  && memcmp(
+		         record.run_lengths, expected.run_lengths,
+		         sizeof(record.run_lengths)
+		     ) == 0;
+	}
+
+	if (file != NULL) {
+		fclose(file);
+	}
+	unlink(filename);
+	return ok;
+}
+
+static bool bench_analysis(struct Bench* bench, size_t width) {
+	uint8_t* row = malloc((width + 7) / 8);
+	if (row == NULL) {
+		return false;
+	}
+
+	if (!check_analysis(row, width)) {
+		fprintf(stderr, "error: analysis went wrong for width %zu\n", width);
+		free(row);
+		return false;
+	}
+
+	static const struct {
+		const char* name;
+		enum AnalysisKind kind;
+	} kinds[] = {
+		{"analysis_write_row_csv", ANALYSIS_CSV},
+		{"analysis_write_row_binary", ANALYSIS_BINARY}
+	};
+
+	bool ok = true;
+	for (size_t k = 0; ok && k < sizeof(kinds) / sizeof(*kinds); ++k) {
+		/* as many rows as are written, which are thrown away */
+		struct AnalysisCase c = {
+			analysis_open(
+				"/dev/null", width, SIZE_MAX, 0, 1, kinds[k].kind
+			),
+			row
+		};
+		ok = c.analysis != NULL;
+		if (!ok) {
+			break;
+		}
+
+		struct Result result = {
+			.group = "analysis",
+			.name = kinds[k].name,
+			.mode = MODE_UNKNOWN,
+			.rule = -1,
+			.width = width,
+			.cells = width,
+			.bytes = (width + 7) / 8
+		};
+
+		measure(bench, &result, analysis_measure, &c);
+		print_result(bench, &result);
+
+		/* which reports the rows as short of `height` */
+		analysis_close(c.analysis);
+	}
+
+	free(row);
+	return ok;
+}
+
+/* hashlife ****************************************************************/
+struct HashLifeCase {
+	struct HashLife* life;
+	uint64_t* row;
+	size_t width;
+	bool ok;
+};
+
+static void hashlife_jump(void* context) {
+	struct HashLifeCase* c = context;
+	c->ok = hashlife_advance(c->life, c->row, c->width, hashlife_generations)
+	     && c->ok;
+}
+
+static bool bench_hashlife(struct Bench* bench, uint8_t rule) {
+	size_t width = hashlife_width;
+	size_t size = eca_packed_words(width) * sizeof(uint64_t);
+
+	struct HashLifeCase c = {
+		hashlife_create(rule, hashlife_memory), malloc(size), width, true
+	};
+	uint64_t* rows[2] = {malloc(size), malloc(size)};
+
+	bool ok = c.life != NULL && c.row != NULL
+	       && rows[0] != NULL && rows[1] != NULL;
+	if (ok) {
+		eca_packed_initialise_random(rows[0], width, 1);
+		memcpy(c.row, rows[0], size);
+
+		for (uint64_t t = 0; t < hashlife_generations; ++t) {
+			eca_packed_generate(rows[1], rows[0], width, 1, &rule);
+
+			uint64_t* tmp = rows[0];
+			rows[0] = rows[1];
+			rows[1] = tmp;
+		}
+
+		hashlife_jump(&c);
+
+		struct HashLifeStats stats;
+		hashlife_stats(c.life, &stats);
+		ok = c.ok && memcmp(c.row, rows[0], size) == 0
+		  && stats.memory <= hashlife_memory;
+		if (!ok) {
+			fprintf(stderr, "error: hashlife went wrong for rule %d\n", rule);
+		}
+	}
+
+	if (ok) {
+		struct Result result = {
+			.group = "hashlife",
+			.name = "hashlife_advance",
+			.mode = MODE_STANDARD,
+			.rule = rule,
+			.width = width,
+			.cells = width * hashlife_generations,
+			.bytes = size
+		};
+
+		measure(bench, &result, hashlife_jump, &c);
+		print_result(bench, &result);
+		ok = c.ok;
+	}
+
+	free(rows[1]);
+	free(rows[0]);
+	free(c.row);
+	if (c.life != NULL) {
+		hashlife_destroy(c.life);
+	}
+	return ok;
+}
+
+/* png *********************************************************************/
+struct PngCase {
+	const uint8_t* pixels; /* every row of the image */
+	size_t width;
+	size_t height;
+	bool ok;
+};
+
+static void png_encode(void* context) {
+	struct PngCase* c = context;
+	size_t row_size = c->width * 3;
+
+	struct PngWriter* png = png_open(
+		"/dev/null", c->width, c->height, PNG_RGB, 8, 6, 1
+	);
+	if (png == NULL) {
+		c->ok = false;
+		return;
+	}
+
+	for (size_t i = 0; c->ok && i < c->height; ++i) {
+		c->ok = png_write_row(png, c->pixels + (i * row_size));
+	}
+	c->ok = png_close(png) && c->ok;
+}
+
+static bool bench_png(struct Bench* bench, size_t width) {
+	/* successive generations of rule 30, as an image would hold */
+	size_t height = (width < png_pixels) ? png_pixels / width : 1;
+	size_t row_size = palette_row_size(FORMAT_RGB, width);
+	size_t words = eca_packed_words(width);
+
+	uint8_t* pixels = malloc(height * row_size);
+	uint64_t* rows[2] = {
+		malloc(words * sizeof(uint64_t)), malloc(words * sizeof(uint64_t))
+	};
+
+	bool ok = pixels != NULL && rows[0] != NULL && rows[1] != NULL;
+	if (ok) {
+		struct Palette palette;
+		palette_standard(&palette);
+		uint8_t rule[1] = {30};
+
+		eca_packed_initialise_random(rows[0], width, 1);
+		for (size_t i = 0; i < height; ++i) {
+			palette_apply(
+				&palette, FORMAT_RGB, pixels + (i * row_size), rows[0], width
+			);
+			eca_packed_generate(rows[1], rows[0], width, 1, rule);
+
+			uint64_t* tmp = rows[0];
+			rows[0] = rows[1];
+			rows[1] = tmp;
+		}
+	}
+
+	if (ok) {
+		struct PngCase c = {pixels, width, height, true};
+		struct Result result = {
+			.group = "png",
+			.name = "png_write_row",
+			.mode = MODE_STANDARD,
+			.rule = 30,
+			.width = width,
+			.cells = width * height,
+			.bytes = row_size * height
+		};
+
+		measure(bench, &result, png_encode, &c);
+		print_result(bench, &result);
+		ok = c.ok;
+	}
+
+	free(rows[1]);
+	free(rows[0]);
+	free(pixels);
+	return ok;
+}
+
+int main(int argc, char* argv[]) {
+	struct Bench bench = {
+		.format = BENCH_CSV,
+		.repetitions = 5,
+		.min_time = 0.01,
+		.max_width = widths[(sizeof(widths) / sizeof(*widths)) - 1]
+	};
+
+	int c = -1;
+	while ((c = getopt(argc, argv, "hf:r:t:W:")) != -1) {
+		switch (c) {
+			case 'f': {
+				if (strcmp(optarg, "csv") == 0) {
+					bench.format = BENCH_CSV;
+				} else if (strcmp(optarg, "json") == 0) {
+					bench.format = BENCH_JSON;
+				} else {
+					printf("%s: invalid argument for option -- 'f'\n", argv[0]);
+					printf("    choice {csv, json}\n");
+					return 1;
+				}
+				break;
+			}
+			case 'r': bench.repetitions = atoi(optarg); break;
+			case 't': bench.min_time = atof(optarg);    break;
+			case 'W': bench.max_width = atol(optarg);   break;
+			case 'h': printf("%s", bench_help_text); return 0;
+			default:  printf("%s", bench_help_text); return 1;
+		}
+	}
+
+	if (bench.repetitions < 1 || bench.min_time <= 0) {
+		printf("%s: repetitions and time must be positive\n", argv[0]);
+		return 1;
+	}
+
+	bool ok = true;
+	for (size_t i = 0; ok && i < sizeof(widths) / sizeof(*widths); ++i) {
+		if (widths[i] > bench.max_width) {
+			break;
+		}
+
+		ok = bench_packed(&bench, widths[i])
+		  && bench_bytes(&bench, widths[i])
+		  && bench_rng(&bench, widths[i])
+		  && bench_analysis(&bench, widths[i])
+		  && bench_png(&bench, widths[i]);
+	}
+
+	size_t lut_count = (lut_width <= bench.max_width)
+		? sizeof(lut_rules) / sizeof(*lut_rules) : 0;
+	for (size_t i = 0; ok && i < lut_count; ++i) {
+		ok = bench_lut(&bench, lut_rules[i]);
+	}
+
+	size_t hashlife_count = (hashlife_width <= bench.max_width)
+		? sizeof(hashlife_rules) / sizeof(*hashlife_rules) : 0;
+	for (size_t i = 0; ok && i < hashlife_count; ++i) {
+		ok = bench_hashlife(&bench, hashlife_rules[i]);
+	}
+
+	if (bench.format == BENCH_JSON) {
+		printf((bench.result_count == 0) ? "[]\n" : "\n]\n");
+	}
+
+	if (!ok) {
+		fprintf(stderr, "error: a benchmark could not be run\n");
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,325 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "analysis.h"
+
+#include "stats.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* records are gathered until this many bytes before they are written */
+#define BUFFER_SIZE (1024 * 1024)
+
+/* room for the longest CSV line */
+#define RECORD_SIZE 512
+
+/* counts of blocks below this have `n * log2(n)` looked up */
+#define LOG_TABLE_SIZE 1024
+
+struct AnalysisWriter {
+	int fd;
+	bool is_stdout;
+	enum AnalysisKind kind;
+
+	size_t width;
+	size_t height;
+	size_t rows_written;
+	uint64_t start;
+	uint64_t stride;
+
+	char* buffer;
+	size_t buffered;
+	bool ok;
+
+	/* the number of each kind of block in the row being measured */
+	uint32_t counts[256];
+	double n_log_n[LOG_TABLE_SIZE];
+};
+
+/* writes all of `data`, as `write` may take only part of it */
+static bool write_all(int fd, const char* data, size_t size) {
+	while (size > 0) {
+		ssize_t count = write(fd, data, size);
+		if (count < 0 && errno == EINTR) {
+			continue;
+		}
+		if (count <= 0) {
+			return false;
+		}
+
+		stats_count(STATS_BYTES_WRITTEN, count);
+		data += count;
+		size -= count;
+	}
+
+	return true;
+}
+
+static bool flush(struct AnalysisWriter* analysis) {
+	bool ok = write_all(analysis->fd, analysis->buffer, analysis->buffered);
+	analysis->buffered = 0;
+
+	return ok;
+}
+
+struct AnalysisWriter* analysis_open(
+	const char* filename, size_t width, size_t height,
+	uint64_t start, uint64_t stride, enum AnalysisKind kind
+) {
+	struct AnalysisWriter* analysis = calloc(1, sizeof(*analysis));
+	if (analysis == NULL) {
+		return NULL;
+	}
+
+	analysis->kind = kind;
+	analysis->width = width;
+	analysis->height = height;
+	analysis->start = start;
+	analysis->stride = stride;
+	analysis->buffer = malloc(BUFFER_SIZE);
+	analysis->ok = true;
+
+	for (size_t n = 1; n < LOG_TABLE_SIZE; ++n) {
+		analysis->n_log_n[n] = n * log2(n);
+	}
+
+	analysis->is_stdout = strcmp(filename, "-") == 0;
+	analysis->fd = analysis->is_stdout ? STDOUT_FILENO : open(
+		filename, O_WRONLY | O_CREAT | O_TRUNC, 0666
+	);
+
+	if (analysis->buffer == NULL || analysis->fd < 0) {
+		if (analysis->fd >= 0 && !analysis->is_stdout) {
+			close(analysis->fd);
+		}
+		free(analysis->buffer);
+		free(analysis);
+		return NULL;
+	}
+
+	if (kind == ANALYSIS_CSV) {
+		const char* header = "generation,ones,density,runs,centre,entropy";
+		char* dst = analysis->buffer;
+		dst += sprintf(dst, "%s", header);
+		for (int n = 1; n <= ANALYSIS_RUN_LENGTHS; ++n) {
+			dst += sprintf(dst, ",run_%d", n);
+		}
+		dst += sprintf(dst, ",run_longer\n");
+		analysis->buffered = dst - analysis->buffer;
+	}
+
+	stats_count(STATS_IMAGES, 1);
+	return analysis;
+}
+
+/* 8 cells of `row` from `i`, the first in the most significant bit */
+static uint64_t load_cells(const uint8_t* row, size_t i) {
+	uint64_t cells = 0;
+	for (int k = 0; k < 8; ++k) {
+		cells = (cells << 8) | row[i + k];
+	}
+
+	return cells;
+}
+
+/* the activated cells of a word which follow a clear cell */
+static uint64_t run_starts(uint64_t cells, uint64_t before) {
+	return cells & ~((cells >> 1) | (before << 63));
+}
+
+static void add_run(struct AnalysisRecord* record, uint64_t length) {
+	if (length > ANALYSIS_RUN_LENGTHS) {
+		record->longer_runs += 1;
+	} else {
+		record->run_lengths[length - 1] += 1;
+	}
+}
+
+/*
+ * Adds the runs of a word to the lengths of `record`, the first cell in the
+ * most significant bit. A run reaching the end of the word is left in
+ * `carry`, its length so far, to be continued by the next word.
+ */
+static void count_runs(
+	struct AnalysisRecord* record, uint64_t cells, uint64_t* carry
+) {
+	if (*carry > 0 && (cells >> 63) == 0) {
+		add_run(record, *carry);
+		*carry = 0;
+	}
+
+	/* the first and last cells of each stretch of activated cells */
+	uint64_t starts = cells & ~(cells >> 1);
+	uint64_t ends = cells & ~(cells << 1);
+
+	while (starts != 0) {
+		int first = 63 - __builtin_clzll(starts);
+		int last = 63 - __builtin_clzll(ends);
+		starts &= ~(1ULL << first);
+		ends &= ~(1ULL << last);
+
+		uint64_t length = first - last + 1;
+		if (first == 63) {
+			length += *carry;
+			*carry = 0;
+		}
+
+		if (last == 0) {
+			*carry = length;
+		} else {
+			add_run(record, length);
+		}
+	}
+}
+
+static double n_log_n(const struct AnalysisWriter* analysis, uint32_t n) {
+	return (n < LOG_TABLE_SIZE) ? analysis->n_log_n[n] : n * log2(n);
+}
+
+/*
+ * counts the cells of a row, and its runs by length, and the entropy of its
+ * blocks
+ */
+static void measure(
+	struct AnalysisWriter* analysis, struct AnalysisRecord* record,
+	const uint8_t* row
+) {
+	size_t width = analysis->width;
+	size_t size = (width + 7) / 8;
+	uint64_t ones = 0;
+	uint64_t runs = 0;
+	uint64_t before = 0; /* the cell before the word, in the lowest bit */
+	uint64_t carry = 0;  /* the length of a run reaching the word */
+
+	memset(record->run_lengths, 0, sizeof(record->run_lengths));
+	record->longer_runs = 0;
+
+	/* a run starts at each activated cell which follows a clear one */
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		uint64_t cells = load_cells(row, i);
+		ones += __builtin_popcountll(cells);
+		runs += __builtin_popcountll(run_starts(cells, before));
+		count_runs(record, cells, &carry);
+		before = cells & 1;
+	}
+
+	/* the cells past the end of the row are clear */
+	if (i < size) {
+		uint8_t tail[8] = {0};
+		memcpy(tail, row + i, size - i);
+		if (width % 8 != 0) {
+			tail[size - i - 1] &= 0xff << (8 - (width % 8));
+		}
+
+		uint64_t cells = load_cells(tail, 0);
+		ones += __builtin_popcountll(cells);
+		runs += __builtin_popcountll(run_starts(cells, before));
+		count_runs(record, cells, &carry);
+	}
+
+	if (carry > 0) {
+		add_run(record, carry);
+	}
+
+	/*
+	 * blocks of 8 cells are the bytes of the row, partial blocks are left,
+	 * and each count is cleared once it is summed
+	 */
+	size_t blocks = width / 8;
+	for (size_t b = 0; b < blocks; ++b) {
+		analysis->counts[row[b]] += 1;
+	}
+
+	double sum = 0.0;
+	for (size_t b = 0; b < blocks; ++b) {
+		uint32_t* count = &analysis->counts[row[b]];
+		if (*count != 0) {
+			sum += n_log_n(analysis, *count);
+			*count = 0;
+		}
+	}
+
+	size_t centre = width / 2;
+	record->ones = ones;
+	record->runs = runs;
+	record->centre = (row[centre / 8] >> (7 - (centre % 8))) & 1;
+	record->entropy = (blocks > 0) ? (log2(blocks) - (sum / blocks)) / 8
+	                               : 0.0;
+}
+
+bool analysis_write_row(struct AnalysisWriter* analysis, const uint8_t* row) {
+	if (analysis->rows_written >= analysis->height || !analysis->ok) {
+		return false;
+	}
+
+	uint64_t begin = stats_clock();
+
+	struct AnalysisRecord record;
+	record.generation = analysis->start
+	                  + (analysis->rows_written * analysis->stride);
+	measure(analysis, &record, row);
+	analysis->rows_written += 1;
+
+	if (BUFFER_SIZE - analysis->buffered < RECORD_SIZE) {
+		analysis->ok = flush(analysis);
+	}
+
+	char* dst = analysis->buffer + analysis->buffered;
+	switch (analysis->kind) {
+		default:
+		case ANALYSIS_CSV: {
+			char* line = dst;
+			dst += sprintf(
+				dst, "%llu,%llu,%.6f,%llu,%llu,%.6f",
+				(unsigned long long)record.generation,
+				(unsigned long long)record.ones,
+				(double)record.ones / analysis->width,
+				(unsigned long long)record.runs,
+				(unsigned long long)record.centre,
+				record.entropy
+			);
+			for (int n = 0; n < ANALYSIS_RUN_LENGTHS; ++n) {
+				dst += sprintf(
+					dst, ",%llu", (unsigned long long)record.run_lengths[n]
+				);
+			}
+			dst += sprintf(
+				dst, ",%llu\n", (unsigned long long)record.longer_runs
+			);
+			analysis->buffered += dst - line;
+			break;
+		}
+		case ANALYSIS_BINARY: {
+			memcpy(dst, &record, sizeof(record));
+			analysis->buffered += sizeof(record);
+			break;
+		}
+	}
+
+	stats_end(STATS_ENCODE, begin);
+	stats_count(STATS_ROWS, 1);
+
+	return analysis->ok;
+}
+
+bool analysis_close(struct AnalysisWriter* analysis) {
+	uint64_t begin = stats_clock();
+	bool ok = analysis->ok && analysis->rows_written == analysis->height
+	       && flush(analysis);
+
+	if (!analysis->is_stdout && close(analysis->fd) != 0) {
+		ok = false;
+	}
+
+	free(analysis->buffer);
+	free(analysis);
+	stats_end(STATS_ENCODE, begin);
+
+	return ok;
+}
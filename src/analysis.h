@@ -0,0 +1,69 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Measures each generation instead of drawing it, writing one record per row
+ * as a line of CSV or as a fixed size binary record. Rows are measured as
+ * they arrive and then dropped, so nothing is kept but the counts of the row
+ * being measured, and the records go through a large buffer as `pnm.h` does.
+ *
+ * Rows are in the mono format of `palette.h`, with a bit set for each
+ * activated cell, see `palette_states`.
+ */
+
+enum AnalysisKind {
+	ANALYSIS_CSV    = 1,
+	ANALYSIS_BINARY = 2
+};
+
+/* runs are counted by length up to this, and longer runs together */
+#define ANALYSIS_RUN_LENGTHS 16
+
+/*
+ * A binary record, written in the byte order of the machine. CSV lines have
+ * the same fields, with the density of activated cells after `ones`, and the
+ * run lengths as the columns `run_1` to `run_16` and `run_longer`.
+ */
+struct AnalysisRecord {
+	uint64_t generation;
+	uint64_t ones;    /* activated cells */
+	uint64_t runs;    /* runs of consecutive activated cells */
+	uint64_t centre;  /* the state of the centre cell, 0 or 1 */
+	double entropy;   /* of the blocks of 8 cells, in bits per cell */
+
+	/* runs of `n + 1` cells, and of more than ANALYSIS_RUN_LENGTHS cells */
+	uint64_t run_lengths[ANALYSIS_RUN_LENGTHS];
+	uint64_t longer_runs;
+};
+
+struct AnalysisWriter;
+
+/**
+ * Creates `filename`, or uses stdout if it is "-", and writes the CSV header.
+ *
+ * - row `n` is labelled generation `start + (n * stride)`.
+ * - returns NULL on failure.
+ */
+struct AnalysisWriter* analysis_open(
+	const char* filename, size_t width, size_t height,
+	uint64_t start, uint64_t stride, enum AnalysisKind kind
+);
+
+/**
+ * Measures the next row and writes its record.
+ */
+bool analysis_write_row(struct AnalysisWriter* analysis, const uint8_t* row);
+
+/**
+ * Writes out what is buffered and closes the file.
+ *
+ * - fails if fewer rows were written than `height`.
+ * - the writer is freed either way.
+ */
+bool analysis_close(struct AnalysisWriter* analysis);
+
+#endif /* ANALYSIS_H */
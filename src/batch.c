@@ -0,0 +1,335 @@
+#include "batch.h"
+
+#include "lut.h"
+#include "pool.h"
+#include "render.h"
+#include "symmetry.h"
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LINE 4096
+#define MAX_ARGS 64
+
+/* the end of a list of jobs */
+#define NO_JOB SIZE_MAX
+
+/* rows of a canonical image are shared by its group up to this many bytes */
+static const size_t group_limit = 64 << 20;
+
+/*
+ * Jobs whose rules are equivalent under `symmetry.h`, the canonical rule is
+ * rendered once and every image of the group is derived from it.
+ */
+struct Group {
+	struct Options canonical;
+	size_t first; /* first job, the rest are linked by `Batch.next_job` */
+	size_t last;
+	size_t count;
+};
+
+struct Batch {
+	struct Options* jobs;
+	enum Symmetry* symmetries;
+	size_t* next_job;
+
+	struct Group* groups;
+	size_t group_count;
+
+	bool failed;
+};
+
+static void render_job(struct Batch* batch, size_t index) {
+	const struct Options* job = &batch->jobs[index];
+
+	char* filename = make_filename(job);
+	if (!render_file(job, filename, NULL)) {
+		fprintf(stderr, "error: could not write %s\n", filename);
+		__atomic_store_n(&batch->failed, true, __ATOMIC_RELAXED);
+	}
+
+	free(filename);
+}
+
+/* where the rows of a canonical image are stored */
+struct Rows {
+	uint8_t* data;
+	size_t row_size;
+};
+
+static bool store_row(void* context, const uint8_t* row, size_t index) {
+	struct Rows* rows = context;
+	memcpy(rows->data + (rows->row_size * index), row, rows->row_size);
+
+	return true;
+}
+
+/* returns false if the canonical image could not be kept */
+static bool render_group(struct Batch* batch, const struct Group* group) {
+	const struct Options* canonical = &group->canonical;
+
+	struct Rows rows = {
+		.row_size = palette_row_size(FORMAT_MONO, canonical->width)
+	};
+	if (canonical->height > group_limit / rows.row_size) {
+		return false;
+	}
+
+	rows.data = malloc(canonical->height * rows.row_size);
+	if (rows.data == NULL) {
+		return false;
+	}
+
+	struct Palette palette;
+	render_palette(&palette, canonical->mode);
+	if (!render(canonical, &palette, FORMAT_MONO, store_row, &rows)) {
+		free(rows.data);
+		return false;
+	}
+
+	for (size_t i = group->first; i != NO_JOB; i = batch->next_job[i]) {
+		const struct Options* job = &batch->jobs[i];
+
+		char* filename = make_filename(job);
+		if (!render_file_derived(
+			job, filename, rows.data, batch->symmetries[i]
+		)) {
+			fprintf(stderr, "error: could not write %s\n", filename);
+			__atomic_store_n(&batch->failed, true, __ATOMIC_RELAXED);
+		}
+		free(filename);
+	}
+
+	free(rows.data);
+	return true;
+}
+
+static void group_task(void* context, size_t index) {
+	struct Batch* batch = context;
+	const struct Group* group = &batch->groups[index];
+
+	/* a job alone in its group is rendered directly */
+	if (group->count > 1 && render_group(batch, group)) {
+		return;
+	}
+
+	for (size_t i = group->first; i != NO_JOB; i = batch->next_job[i]) {
+		render_job(batch, i);
+	}
+}
+
+/* whether two jobs render the same image */
+static bool same_image(const struct Options* a, const struct Options* b) {
+	return a->mode == b->mode && a->initial == b->initial
+	    && a->engine == b->engine && a->width == b->width
+	    && a->height == b->height && a->stride == b->stride
+	    && a->start == b->start && a->memory_limit == b->memory_limit
+	    && a->seeded == b->seeded && a->seed == b->seed
+	    && a->density == b->density
+	    && memcmp(a->rules, b->rules, sizeof(a->rules)) == 0;
+}
+
+/* links each job into the group of its canonical rule */
+static void group_jobs(struct Batch* batch, size_t job_count) {
+	for (size_t i = 0; i < job_count; ++i) {
+		struct Options canonical = batch->jobs[i];
+		canonical.rules[0] = symmetry_canonical(
+			&batch->jobs[i], &batch->symmetries[i]
+		);
+		batch->next_job[i] = NO_JOB;
+
+		size_t g = 0;
+		while (
+			g < batch->group_count
+			&& !same_image(&batch->groups[g].canonical, &canonical)
+		) {
+			++g;
+		}
+
+		/* jobs are kept in order, so images are written in the usual order */
+		struct Group* group = &batch->groups[g];
+		if (g == batch->group_count) {
+			*group = (struct Group){canonical, i, i, 0};
+			batch->group_count += 1;
+		} else {
+			batch->next_job[group->last] = i;
+			group->last = i;
+		}
+		group->count += 1;
+	}
+}
+
+bool batch_run(const struct Options* jobs, size_t job_count, int thread_count) {
+	if (job_count == 0) {
+		return true;
+	}
+
+	struct Batch batch = {
+		.jobs = malloc(job_count * sizeof(*jobs)),
+		.symmetries = malloc(job_count * sizeof(*batch.symmetries)),
+		.next_job = malloc(job_count * sizeof(*batch.next_job)),
+		.groups = malloc(job_count * sizeof(*batch.groups)),
+		.group_count = 0,
+		.failed = false
+	};
+
+	bool ok = batch.jobs != NULL && batch.symmetries != NULL
+	       && batch.next_job != NULL && batch.groups != NULL;
+	struct Pool* pool = NULL;
+
+	if (ok) {
+		/* threads left over once every job has one are shared between jobs */
+		int job_threads = 1;
+		if ((size_t)thread_count > job_count) {
+			job_threads = thread_count / job_count;
+		}
+
+		for (size_t i = 0; i < job_count; ++i) {
+			batch.jobs[i] = jobs[i];
+			batch.jobs[i].headless = true;
+			batch.jobs[i].threads = job_threads;
+		}
+
+		group_jobs(&batch, job_count);
+
+		/*
+		 * tables are built up front rather than by every thread at once,
+		 * for the canonical rules too
+		 */
+		for (size_t i = 0; i < job_count; ++i) {
+			if (jobs[i].engine == ENGINE_LUT) {
+				eca_lut_prepare(jobs[i].rules, 3);
+			}
+		}
+		for (size_t g = 0; g < batch.group_count; ++g) {
+			const struct Options* canonical = &batch.groups[g].canonical;
+			if (canonical->engine == ENGINE_LUT) {
+				eca_lut_prepare(canonical->rules, 3);
+			}
+		}
+
+		int pool_threads = thread_count;
+		if ((size_t)pool_threads > batch.group_count) {
+			pool_threads = batch.group_count;
+		}
+
+		pool = pool_create(pool_threads);
+		ok = pool != NULL;
+	}
+
+	if (ok) {
+		pool_run(pool, group_task, &batch, batch.group_count);
+		pool_destroy(pool);
+	}
+
+	free(batch.groups);
+	free(batch.next_job);
+	free(batch.symmetries);
+	free(batch.jobs);
+
+	return ok && !batch.failed;
+}
+
+/* splits a line into arguments at whitespace, returning the count */
+static int split_line(char* line, char* args[], int max_args) {
+	int count = 0;
+	char* p = line;
+
+	for (;;) {
+		while (isspace((unsigned char)*p)) {
+			++p;
+		}
+		if (*p == 0 || count == max_args) {
+			break;
+		}
+
+		args[count++] = p;
+		while (*p != 0 && !isspace((unsigned char)*p)) {
+			++p;
+		}
+		if (*p != 0) {
+			*p++ = 0;
+		}
+	}
+
+	return count;
+}
+
+bool batch_run_file(const char* filename, int thread_count) {
+	bool from_stdin = strcmp(filename, "-") == 0;
+	FILE* file = from_stdin ? stdin : fopen(filename, "r");
+	if (file == NULL) {
+		fprintf(stderr, "error: could not open %s\n", filename);
+		return false;
+	}
+
+	struct Options* jobs = NULL;
+	size_t job_count = 0;
+	bool ok = true;
+
+	char line[MAX_LINE];
+	char label[64];
+	size_t line_number = 0;
+
+	while (ok && fgets(line, sizeof(line), file) != NULL) {
+		line_number += 1;
+
+		/* each line is parsed as though it followed the program name */
+		char* args[MAX_ARGS + 1];
+		snprintf(label, sizeof(label), "%.40s:%zu", filename, line_number);
+		args[0] = label;
+
+		int arg_count = 1 + split_line(line, args + 1, MAX_ARGS);
+		if (arg_count == 1 || args[1][0] == '#') {
+			continue;
+		}
+
+		struct Options options = {0};
+		struct Selection selection;
+		enum ParseStatus ps = parse_args(
+			&options, &selection, arg_count, args
+		);
+
+		/* jobs are always saved under their own names */
+		if (ps != PARSE_OK || options.batch_file != NULL
+		 || options.output_file != NULL || options.live > 0
+		 || options.checkpoint_file != NULL || options.resume_file != NULL
+		 || options.output == OUTPUT_RNG || options.initial_file != NULL
+		 || options.mode == MODE_LIST_RULES) {
+			fprintf(stderr, "error: bad job on line %zu\n", line_number);
+			ok = false;
+			break;
+		}
+
+		size_t count = options_expand(&options, &selection, NULL);
+		struct Options* grown = realloc(
+			jobs, (job_count + count) * sizeof(*jobs)
+		);
+		if (grown == NULL) {
+			ok = false;
+			break;
+		}
+
+		jobs = grown;
+		options_expand(&options, &selection, jobs + job_count);
+		job_count += count;
+	}
+
+	if (ferror(file)) {
+		fprintf(stderr, "error: could not read %s\n", filename);
+		ok = false;
+	}
+	if (!from_stdin) {
+		fclose(file);
+	}
+
+	if (ok) {
+		ok = batch_run(jobs, job_count, thread_count);
+	}
+
+	free(jobs);
+	return ok;
+}
@@ -0,0 +1,31 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "options.h"
+
+/*
+ * Batches render many jobs in one process, each saved headless under the
+ * name given by `make_filename`. Jobs are shared between the threads of one
+ * pool, each thread taking the next job as soon as it is free.
+ */
+
+/**
+ * Renders every job on up to `thread_count` threads.
+ *
+ * - returns false if any image could not be written.
+ */
+bool batch_run(const struct Options* jobs, size_t job_count, int thread_count);
+
+/**
+ * Reads jobs from `filename`, one command line per line, and renders them.
+ *
+ * - blank lines and lines starting with '#' are skipped.
+ * - `filename` may be "-" to read from standard input.
+ * - returns false if the file could not be read or any job failed.
+ */
+bool batch_run_file(const char* filename, int thread_count);
+
+#endif /* BATCH_H */
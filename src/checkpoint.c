@@ -0,0 +1,200 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "checkpoint.h"
+
+#include "packed.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* set by the signal handlers, and read between generations */
+static volatile sig_atomic_t requested = 0;
+static volatile sig_atomic_t stopping = 0;
+
+/* the run stopped, with its checkpoint saved */
+static bool stopped = false;
+
+bool checkpoint_open(struct Checkpoint* checkpoint, const char* filename) {
+	memset(checkpoint, 0, sizeof(*checkpoint));
+
+	int fd = open(filename, O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0) {
+		fprintf(stderr, "error: could not open checkpoint %s\n", filename);
+		if (fd >= 0) {
+			close(fd);
+		}
+		return false;
+	}
+
+	size_t size = st.st_size;
+	void* data = MAP_FAILED;
+	if (size >= sizeof(struct CheckpointHeader)) {
+		data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+	close(fd);
+
+	if (data == MAP_FAILED) {
+		fprintf(stderr, "error: %s is not a checkpoint\n", filename);
+		return false;
+	}
+
+	const struct CheckpointHeader* header = data;
+	checkpoint->header = header;
+	checkpoint->size = size;
+
+	/* the row must be whole, and be the row of the mode */
+	uint64_t words = eca_packed_words(header->width);
+	bool valid = memcmp(header->magic, CHECKPOINT_MAGIC, 8) == 0
+	          && header->version == CHECKPOINT_VERSION
+	          && header->header_size == sizeof(*header)
+	          && header->boundary == BOUNDARY_PERIODIC
+	          && header->mode > MODE_UNKNOWN
+	          && header->mode < MODE_LIST_RULES
+	          && header->initial > INIT_UNKNOWN
+	          && header->initial < INIT_LAST
+	          && header->width > 0 && header->width <= INT32_MAX
+	          && header->words == words
+	          && header->plane_count >= 1
+	          && header->plane_count <= ECA_PLANES_DIRECTIONAL
+	          && (size - sizeof(*header)) / sizeof(uint64_t) / words
+	             >= header->plane_count;
+
+	if (!valid) {
+		fprintf(stderr, "error: %s is not a checkpoint\n", filename);
+		checkpoint_close(checkpoint);
+		return false;
+	}
+
+	checkpoint->row = (const uint64_t*)(header + 1);
+	return true;
+}
+
+void checkpoint_close(struct Checkpoint* checkpoint) {
+	if (checkpoint->header != NULL) {
+		munmap((void*)checkpoint->header, checkpoint->size);
+	}
+
+	memset(checkpoint, 0, sizeof(*checkpoint));
+}
+
+void checkpoint_apply(
+	const struct Checkpoint* checkpoint, struct Options* options
+) {
+	const struct CheckpointHeader* header = checkpoint->header;
+
+	options->mode = header->mode;
+	options->initial = header->initial;
+	options->width = header->width;
+	memcpy(options->rules, header->rules, sizeof(options->rules));
+}
+
+/* writes all of `data`, as `write` may take only part of it */
+static bool write_all(int fd, const void* data, size_t size) {
+	const uint8_t* bytes = data;
+	while (size > 0) {
+		ssize_t count = write(fd, bytes, size);
+		if (count <= 0) {
+			return false;
+		}
+
+		bytes += count;
+		size -= count;
+	}
+
+	return true;
+}
+
+bool checkpoint_write(
+	const char* filename, const struct Options* options, int plane_count,
+	const uint64_t* row, uint64_t generation
+) {
+	struct CheckpointHeader header = {
+		.version = CHECKPOINT_VERSION,
+		.header_size = sizeof(header),
+		.generation = generation,
+		.width = options->width,
+		.words = eca_packed_words(options->width),
+		.plane_count = plane_count,
+		.mode = options->mode,
+		.initial = options->initial,
+		.boundary = BOUNDARY_PERIODIC
+	};
+	memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+	memcpy(header.rules, options->rules, sizeof(header.rules));
+
+	/* the old checkpoint is only replaced once the new one is whole */
+	size_t length = strlen(filename);
+	char* temporary = malloc(length + 5);
+	if (temporary == NULL) {
+		return false;
+	}
+	memcpy(temporary, filename, length);
+	memcpy(temporary + length, ".tmp", 5);
+
+	int fd = open(temporary, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	size_t size = header.words * plane_count * sizeof(*row);
+
+	bool ok = fd >= 0
+	       && write_all(fd, &header, sizeof(header))
+	       && write_all(fd, row, size);
+
+	if (fd >= 0) {
+		ok = (fsync(fd) == 0) && ok;
+		ok = (close(fd) == 0) && ok;
+	}
+	ok = ok && rename(temporary, filename) == 0;
+
+	if (!ok) {
+		unlink(temporary);
+	}
+	free(temporary);
+
+	return ok;
+}
+
+static void handle_signal(int number) {
+	requested = 1;
+	if (number != SIGUSR1) {
+		stopping = 1;
+	}
+}
+
+bool checkpoint_catch_signals(void) {
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = handle_signal;
+	action.sa_flags = SA_RESTART;
+	sigemptyset(&action.sa_mask);
+
+	return sigaction(SIGUSR1, &action, NULL) == 0
+	    && sigaction(SIGINT, &action, NULL) == 0
+	    && sigaction(SIGTERM, &action, NULL) == 0;
+}
+
+bool checkpoint_requested(void) {
+	if (!requested) {
+		return false;
+	}
+
+	requested = 0;
+	return true;
+}
+
+bool checkpoint_stopping(void) {
+	return stopping;
+}
+
+void checkpoint_set_stopped(void) {
+	stopped = true;
+}
+
+bool checkpoint_stopped(void) {
+	return stopped;
+}
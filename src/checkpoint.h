@@ -0,0 +1,106 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "options.h"
+
+/*
+ * A checkpoint is one packed row of the packed engine, see `packed.h`, with
+ * the generation it was made at and everything needed to carry on from it.
+ * The header is 64 bytes and the row follows it, so a mapped checkpoint is
+ * read in place without a copy. Fields are in the byte order of the machine.
+ *
+ * Checkpoints are written to a temporary file which is then renamed over the
+ * old one, so a run stopped part way through a write leaves the last
+ * checkpoint whole.
+ */
+
+#define CHECKPOINT_MAGIC   "ECA-CKPT"
+#define CHECKPOINT_VERSION 1
+
+/* cells beyond the edges of the row, only wrapping is supported so far */
+enum Boundary {
+	BOUNDARY_PERIODIC = 0
+};
+
+struct CheckpointHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t header_size;  /* bytes before the row */
+	uint64_t generation;
+	uint64_t width;
+	uint64_t words;        /* of each plane */
+	uint32_t plane_count;
+	uint8_t mode;          /* `enum Mode` */
+	uint8_t initial;       /* `enum Initial`, of generation 0 */
+	uint8_t boundary;      /* `enum Boundary` */
+	uint8_t rules[3];
+	uint8_t reserved[14];  /* pads the header to 64 bytes */
+};
+
+struct Checkpoint {
+	const struct CheckpointHeader* header;
+	const uint64_t* row;
+	size_t size; /* of the mapping */
+};
+
+/**
+ * Maps the checkpoint `filename` and checks its header.
+ *
+ * - prints why and returns false if it can not be used.
+ */
+bool checkpoint_open(struct Checkpoint* checkpoint, const char* filename);
+
+void checkpoint_close(struct Checkpoint* checkpoint);
+
+/**
+ * Sets the mode, initial generation, rules, and width of `options` to those
+ * of the run `checkpoint` was taken from.
+ */
+void checkpoint_apply(
+	const struct Checkpoint* checkpoint, struct Options* options
+);
+
+/**
+ * Saves `row`, generation `generation` of the run of `options`.
+ *
+ * - returns false if the file could not be written.
+ */
+bool checkpoint_write(
+	const char* filename, const struct Options* options, int plane_count,
+	const uint64_t* row, uint64_t generation
+);
+
+/**
+ * Saves a checkpoint on SIGUSR1 and carries on, or on SIGINT and SIGTERM
+ * and stops.
+ *
+ * - returns false if the handlers could not be installed.
+ */
+bool checkpoint_catch_signals(void);
+
+/**
+ * Whether a signal asked for a checkpoint since the last call.
+ */
+bool checkpoint_requested(void);
+
+/**
+ * Whether a signal asked for the run to stop.
+ */
+bool checkpoint_stopping(void);
+
+/**
+ * Records that the run stopped at a signal and its last generation was saved.
+ */
+void checkpoint_set_stopped(void);
+
+/**
+ * Whether the run stopped at a signal with its last generation saved, which
+ * cuts its image short.
+ */
+bool checkpoint_stopped(void);
+
+#endif /* CHECKPOINT_H */
@@ -0,0 +1,66 @@
+#include "cycle.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const uint64_t hash_multiplier = 0x9e3779b97f4a7c15;
+
+bool cycle_init(struct Cycle* cycle, size_t words) {
+	*cycle = (struct Cycle){
+		.row = malloc(words * sizeof(*cycle->row)),
+		.words = words
+	};
+
+	return cycle->row != NULL;
+}
+
+void cycle_free(struct Cycle* cycle) {
+	free(cycle->row);
+	cycle->row = NULL;
+}
+
+uint64_t cycle_hash(const uint64_t* words, size_t count, uint64_t hash) {
+	/* four independent lanes keep the multiplier busy */
+	uint64_t lanes[4] = {hash, ~hash, hash ^ count, 0};
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		for (int k = 0; k < 4; ++k) {
+			lanes[k] = (lanes[k] ^ words[i + k]) * hash_multiplier;
+		}
+	}
+	for (; i < count; ++i) {
+		lanes[3] = (lanes[3] ^ words[i]) * hash_multiplier;
+	}
+
+	uint64_t result = count;
+	for (int k = 0; k < 4; ++k) {
+		result = (result ^ lanes[k] ^ (lanes[k] >> 29)) * hash_multiplier;
+	}
+
+	return result ^ (result >> 32);
+}
+
+bool cycle_check(
+	struct Cycle* cycle, const uint64_t* row, uint64_t hash,
+	uint64_t generation
+) {
+	size_t size = cycle->words * sizeof(*row);
+
+	if (
+		cycle->power != 0 && hash == cycle->hash
+		&& memcmp(row, cycle->row, size) == 0
+	) {
+		cycle->period = generation - cycle->generation;
+		return true;
+	}
+
+	if (generation - cycle->generation == cycle->power) {
+		memcpy(cycle->row, row, size);
+		cycle->hash = hash;
+		cycle->generation = generation;
+		cycle->power = (cycle->power == 0) ? 1 : cycle->power * 2;
+	}
+
+	return false;
+}
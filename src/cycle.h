@@ -0,0 +1,51 @@
+#ifndef CYCLE_H
+#define CYCLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Cycle detection, using Brent's algorithm.
+ *
+ * A row is saved, and each generation after it is compared with it. When the
+ * saved row is `power` generations old it is replaced by the current one and
+ * `power` doubles, so a cycle of period `p` is found within about `2p`
+ * generations of the row entering it, keeping only one row. Rows are compared
+ * by hash first, and only rows with equal hashes are compared in full.
+ */
+
+struct Cycle {
+	uint64_t* row;
+	size_t words;
+	uint64_t hash;
+	uint64_t generation; /* generation of the saved row */
+	uint64_t power;      /* 0 until a row is saved */
+	uint64_t period;     /* 0 until a cycle is found */
+};
+
+/**
+ * Prepares to check rows of `words` words.
+ *
+ * - returns false if memory could not be allocated.
+ */
+bool cycle_init(struct Cycle* cycle, size_t words);
+
+void cycle_free(struct Cycle* cycle);
+
+/**
+ * Hashes `words[0, count)`, continuing from `hash`.
+ */
+uint64_t cycle_hash(const uint64_t* words, size_t count, uint64_t hash);
+
+/**
+ * Checks each generation in turn, starting from generation 0.
+ *
+ * - returns true once the row repeats, `cycle->period` is then set.
+ */
+bool cycle_check(
+	struct Cycle* cycle, const uint64_t* row, uint64_t hash,
+	uint64_t generation
+);
+
+#endif /* CYCLE_H */
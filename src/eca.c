@@ -1,13 +1,10 @@
 #include "eca.h"
+#include "rules.h"
 
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 
-uint8_t pixel_off  = 0x00;
-uint8_t pixel_half = 0x45;
-uint8_t pixel_on   = 0xff;
-
 uint8_t get_mirror_rule(uint8_t r) {
 	uint8_t nr = r & 0xa5; /* 0b10100101 already mirrored */
 
@@ -32,33 +29,69 @@ uint8_t get_complement_rule(uint8_t r) {
 	return ~nr;
 }
 
+/* glibc's additive feedback generator, x[n] = x[n - 3] + x[n - 31] */
+void eca_random_seed(struct EcaRandom* random, unsigned int seed) {
+	int32_t word = (seed == 0) ? 1 : seed;
+	random->state[0] = word;
+
+	for (int i = 1; i < 31; ++i) {
+		/* 16807 * word % 2147483647, without overflow */
+		int32_t hi = word / 127773;
+		int32_t lo = word % 127773;
+		word = (16807 * lo) - (2836 * hi);
+		if (word < 0) {
+			word += 2147483647;
+		}
+		random->state[i] = word;
+	}
+
+	random->front = 3;
+	random->rear = 0;
+
+	for (int i = 0; i < 310; ++i) {
+		eca_random_next(random);
+	}
+}
+
+int eca_random_next(struct EcaRandom* random) {
+	uint32_t* state = random->state;
+	state[random->front] += state[random->rear];
+	int result = state[random->front] >> 1;
+
+	random->front = (random->front + 1) % 31;
+	random->rear = (random->rear + 1) % 31;
+
+	return result;
+}
+
 /* populates an initial generation */
 void eca_initialise(uint8_t* dst, size_t width, int channel_count) {
 	size_t row_size = width * channel_count;
-	memset(dst, pixel_off, row_size);
+	memset(dst, ECA_OFF, row_size);
 
 	size_t centre_pixel = (width / 2) * channel_count;
-	memset(dst + centre_pixel, pixel_on, channel_count);
+	memset(dst + centre_pixel, ECA_ON, channel_count);
 }
 
 
 void eca_initialise_alternate(uint8_t* dst, size_t width, int channel_count) {
 	size_t row_size = width * channel_count;
-	memset(dst, pixel_off, row_size);
+	memset(dst, ECA_OFF, row_size);
 
 	for (size_t i = 0; i < width; ++i) {
-		uint8_t val = (i % 2) ? pixel_on : pixel_off;
+		uint8_t val = (i % 2) ? ECA_ON : ECA_OFF;
 		memset(dst + (i * channel_count), val, channel_count);
 	}
 }
 
 void eca_initialise_random(uint8_t* dst, size_t width, int channel_count) {
 	size_t row_size = width * channel_count;
-	memset(dst, pixel_off, row_size);
+	memset(dst, ECA_OFF, row_size);
 
-	srand(0);
+	struct EcaRandom random;
+	eca_random_seed(&random, 0);
 	for (size_t i = 0; i < width; ++i) {
-		uint8_t val = (rand() % 2) ? pixel_on : pixel_off;
+		uint8_t val = (eca_random_next(&random) % 2) ? ECA_ON : ECA_OFF;
 		memset(dst + (i * channel_count), val, channel_count);
 	}
 }
@@ -83,19 +116,19 @@ void eca_generate(
 
 		/* convert to rule index */
 		char rule_index = 0;
-		if (src[left_pixel] == pixel_on) {
+		if (src[left_pixel] == ECA_ON) {
 			rule_index |= 4;
 		}
-		if (src[pixel_index] == pixel_on) {
+		if (src[pixel_index] == ECA_ON) {
 			rule_index |= 2;
 		}
-		if (src[right_pixel] == pixel_on) {
+		if (src[right_pixel] == ECA_ON) {
 			rule_index |= 1;
 		}
 
 		bool fill_pixel = ((rules[0] >> rule_index) & 1) == 1;
 		if (fill_pixel) {
-			memset(dst + pixel_index, pixel_on, channel_count);
+			memset(dst + pixel_index, ECA_ON, channel_count);
 		}
 	}
 }
@@ -120,20 +153,20 @@ void eca_generate_split(
 		/* convert to rule index */
 		for (int channel = 0; channel < 3; ++channel) {
 			uint8_t rule_index = 0;
-			if (src[left_pixel + channel] == pixel_on) {
+			if (src[left_pixel + channel] == ECA_ON) {
 				rule_index |= 4;
 			}
-			if (src[pixel_index + channel] == pixel_on) {
+			if (src[pixel_index + channel] == ECA_ON) {
 				rule_index |= 2;
 			}
-			if (src[right_pixel + channel] == pixel_on) {
+			if (src[right_pixel + channel] == ECA_ON) {
 				rule_index |= 1;
 			}
 
 			bool fill_pixel = \
 				(rules[channel] >> rule_index) & 1;
 			dst[pixel_index + channel] = \
-				fill_pixel ? pixel_on : pixel_off;
+				fill_pixel ? ECA_ON : ECA_OFF;
 		}
 
 	}
@@ -161,13 +194,13 @@ void eca_generate_directional(
 		bool right_set = false;
 
 		for (int channel = 0; channel < channel_count; ++channel) {
-			if (src[left_pixel + channel] != pixel_off) {
+			if (src[left_pixel + channel] != ECA_OFF) {
 				left_set = true;
 			}
-			if (src[pixel_index + channel] != pixel_off) {
+			if (src[pixel_index + channel] != ECA_OFF) {
 				pixel_set = true;
 			}
-			if (src[right_pixel + channel] != pixel_off) {
+			if (src[right_pixel + channel] != ECA_OFF) {
 				right_set = true;
 			}
 		}
@@ -186,9 +219,73 @@ void eca_generate_directional(
 
 		bool fill_pixel = ((rules[0] >> rule_index) & 1) == 1;
 		if (fill_pixel) {
-			dst[pixel_index  ] = left_set  ? pixel_on : pixel_half;
-			dst[pixel_index+1] = pixel_set ? pixel_on : pixel_half;
-			dst[pixel_index+2] = right_set ? pixel_on : pixel_half;
+			dst[pixel_index  ] = left_set  ? ECA_ON : ECA_HALF;
+			dst[pixel_index+1] = pixel_set ? ECA_ON : ECA_HALF;
+			dst[pixel_index+2] = right_set ? ECA_ON : ECA_HALF;
 		}
 	}
 }
+
+/*
+ * Standard generation specialised for each rule.
+ *
+ * Every byte is generated from the same channel of its neighbours, which are
+ * `channel_count` bytes away, so the loop over the middle of the row has no
+ * branches and can be vectorised by the compiler.
+ */
+#define RULE_BYTE(j, left, right, expression) do { \
+	uint8_t l = -(uint8_t)(in[left]  == on); \
+	uint8_t c = -(uint8_t)(in[j]     == on); \
+	uint8_t r = -(uint8_t)(in[right] == on); \
+	(void)l; (void)c; (void)r; \
+	uint8_t fill = (expression); \
+	out[j] = (fill & on) | (~fill & out[j]); \
+} while (0)
+
+#define RULE_KERNEL(rule, expression) \
+static void generate_rule_##rule( \
+	uint8_t* dst, const uint8_t* src, size_t width, int channel_count, \
+	uint8_t rules[channel_count] \
+) { \
+	(void)rules; \
+	uint8_t* restrict out = dst; \
+	const uint8_t* restrict in = src; \
+	const uint8_t on = ECA_ON; \
+	size_t stride = channel_count; \
+	size_t size = width * stride; \
+	size_t tail = (size > stride * 2) ? size - stride : stride; \
+\
+	/* wrap around edges */ \
+	for (size_t j = 0; j < stride && j < size; ++j) { \
+		RULE_BYTE( \
+			j, (j + size - stride) % size, (j + stride) % size, \
+			expression \
+		); \
+	} \
+	for (size_t j = stride; j < tail; ++j) { \
+		RULE_BYTE(j, j - stride, j + stride, expression); \
+	} \
+	for (size_t j = tail; j < size; ++j) { \
+		RULE_BYTE( \
+			j, (j + size - stride) % size, (j + stride) % size, \
+			expression \
+		); \
+	} \
+}
+
+ECA_RULES(RULE_KERNEL)
+
+#undef RULE_KERNEL
+#undef RULE_BYTE
+
+#define RULE_ENTRY(rule, expression) generate_rule_##rule,
+
+static eca_gen_fn* const rule_kernels[256] = {
+	ECA_RULES(RULE_ENTRY)
+};
+
+#undef RULE_ENTRY
+
+eca_gen_fn* eca_rule_kernel(uint8_t rule) {
+	return rule_kernels[rule];
+}
@@ -4,9 +4,13 @@
 #include <stdint.h>
 #include <stddef.h>
 
-extern uint8_t pixel_off;
-extern uint8_t pixel_half;
-extern uint8_t pixel_on;
+/*
+ * The state of each channel of a cell in the byte layout. These are only
+ * states, colours are chosen when a row is passed through a palette.
+ */
+#define ECA_OFF  0x00
+#define ECA_HALF 0x45
+#define ECA_ON   0xff
 
 /**
  * The "mirror" of a rule is reflected horizontally.
@@ -18,6 +22,27 @@ uint8_t get_mirror_rule(uint8_t r);
  */
 uint8_t get_complement_rule(uint8_t r);
 
+/*
+ * The sequence of `rand()` after `srand(seed)` with glibc, which the random
+ * initial generation has always used, but with state of its own so that
+ * generations can be initialised on several threads at once.
+ */
+struct EcaRandom {
+	uint32_t state[31];
+	int front;
+	int rear;
+};
+
+/**
+ * Equivalent to `srand(seed)`.
+ */
+void eca_random_seed(struct EcaRandom* random, unsigned int seed);
+
+/**
+ * Equivalent to `rand()`.
+ */
+int eca_random_next(struct EcaRandom* random);
+
 /* populates an initial generation */
 typedef void eca_init_fn(uint8_t* dst, size_t width, int channel_count);
 
@@ -71,4 +96,12 @@ void eca_generate_directional(
 	uint8_t rules[channel_count]
 );
 
+/**
+ * Standard generation specialised for a single rule.
+ *
+ * - the `rules` argument of the returned function is ignored.
+ * - every channel of a cell is expected to be equal.
+ */
+eca_gen_fn* eca_rule_kernel(uint8_t rule);
+
 #endif /* ECA_H */
@@ -0,0 +1,882 @@
+#include "hashlife.h"
+
+#include "packed.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Blocks of 2^LEAF_LEVEL cells are stored as bits, blocks of 2^BASE_LEVEL
+ * cells are advanced directly, and larger blocks recursively.
+ */
+#define LEAF_LEVEL 5
+#define BASE_LEVEL 6
+
+/* a memo miss costs about as much as stepping this many words directly */
+#define MISS_WORDS 256
+
+/* most jumps stepped directly between tries, so periods are still found */
+#define MAX_BACKOFF 32
+
+/* a block of 2^level cells, `left` holds the cells of a leaf */
+struct Node {
+	uint32_t left;
+	uint32_t right;
+	uint32_t level;
+};
+
+/* the centre half of `node` after 2^step generations */
+struct Memo {
+	uint32_t node;
+	uint32_t step;
+	uint32_t result;
+};
+
+/* the block of 2^level cells starting at `offset` of the row being built */
+struct Built {
+	uint64_t offset;
+	uint32_t level;
+	uint32_t node;
+};
+
+struct HashLife {
+	uint8_t rule;
+	size_t memory_limit;
+	bool failed;
+	bool full; /* a jump needed more nodes than fit in the limit */
+	uint64_t epoch; /* counts collections, each invalidating every node */
+
+	/* jumps left to step directly, and how many to step after the next */
+	uint64_t direct;
+	uint64_t backoff;
+
+	struct Node* nodes;   /* node 0 is never a real block */
+	size_t node_count;
+	size_t node_capacity;
+	uint32_t* node_slots; /* open addressed index into `nodes` */
+	size_t node_slot_mask;
+
+	struct Memo* memo;
+	size_t memo_count;
+	size_t memo_mask;
+
+	struct Built* built;
+	size_t built_count;
+	size_t built_mask;
+
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t collections;
+};
+
+static uint64_t hash3(uint64_t a, uint64_t b, uint64_t c) {
+	uint64_t h = (a * 0x9e3779b97f4a7c15) ^ (b * 0xc2b2ae3d27d4eb4f);
+	h ^= c * 0x165667b19e3779f9;
+	return h ^ (h >> 29);
+}
+
+static size_t memory_used(const struct HashLife* life) {
+	return (life->node_capacity * sizeof(*life->nodes))
+	     + ((life->node_slot_mask + 1) * sizeof(*life->node_slots))
+	     + ((life->memo_mask + 1) * sizeof(*life->memo))
+	     + ((life->built_mask + 1) * sizeof(*life->built));
+}
+
+/* nodes ********************************************************************/
+static bool grow_nodes(struct HashLife* life) {
+	/* doubling adds as many nodes again, and twice as many slots */
+	size_t added = life->node_capacity
+	             * (sizeof(*life->nodes) + (2 * sizeof(*life->node_slots)));
+	if (
+		life->node_count >= UINT32_MAX / 2
+		|| memory_used(life) + added > life->memory_limit
+	) {
+		life->full = true;
+		return false;
+	}
+
+	size_t capacity = life->node_capacity * 2;
+	struct Node* nodes = realloc(life->nodes, capacity * sizeof(*nodes));
+	if (nodes == NULL) {
+		life->failed = true;
+		return false;
+	}
+
+	size_t slot_count = capacity * 2;
+	uint32_t* slots = calloc(slot_count, sizeof(*slots));
+	if (slots == NULL) {
+		life->nodes = nodes;
+		life->failed = true;
+		return false;
+	}
+
+	life->nodes = nodes;
+	life->node_capacity = capacity;
+
+	free(life->node_slots);
+	life->node_slots = slots;
+	life->node_slot_mask = slot_count - 1;
+
+	for (size_t id = 1; id < life->node_count; ++id) {
+		const struct Node* node = &nodes[id];
+		size_t slot = hash3(node->level, node->left, node->right);
+		slot &= life->node_slot_mask;
+
+		while (slots[slot] != 0) {
+			slot = (slot + 1) & life->node_slot_mask;
+		}
+		slots[slot] = id;
+	}
+
+	return true;
+}
+
+/* the one node for a block, creating it if it is new */
+static uint32_t intern(
+	struct HashLife* life, uint32_t level, uint32_t left, uint32_t right
+) {
+	size_t slot = hash3(level, left, right) & life->node_slot_mask;
+
+	for (;;) {
+		uint32_t id = life->node_slots[slot];
+		if (id == 0) {
+			break;
+		}
+
+		const struct Node* node = &life->nodes[id];
+		if (
+			node->level == level
+			&& node->left == left
+			&& node->right == right
+		) {
+			return id;
+		}
+		slot = (slot + 1) & life->node_slot_mask;
+	}
+
+	if (life->node_count == life->node_capacity) {
+		if (!grow_nodes(life)) {
+			return 0;
+		}
+		return intern(life, level, left, right);
+	}
+
+	uint32_t id = life->node_count++;
+	life->nodes[id] = (struct Node){left, right, level};
+	life->node_slots[slot] = id;
+
+	return id;
+}
+
+static uint32_t leaf(struct HashLife* life, uint32_t cells) {
+	return intern(life, LEAF_LEVEL, cells, 0);
+}
+
+static uint32_t join(struct HashLife* life, uint32_t left, uint32_t right) {
+	return intern(life, life->nodes[left].level + 1, left, right);
+}
+
+/* the 64 cells of a base level block */
+static uint64_t base_cells(const struct HashLife* life, uint32_t id) {
+	const struct Node* node = &life->nodes[id];
+	uint64_t left = life->nodes[node->left].left;
+	uint64_t right = life->nodes[node->right].left;
+
+	return left | (right << 32);
+}
+
+/* the centre half of a block, in the same generation */
+static uint32_t centre(struct HashLife* life, uint32_t id) {
+	const struct Node* node = &life->nodes[id];
+
+	if (node->level == BASE_LEVEL) {
+		return leaf(life, base_cells(life, id) >> 16);
+	}
+
+	uint32_t left = life->nodes[node->left].right;
+	uint32_t right = life->nodes[node->right].left;
+	return join(life, left, right);
+}
+
+/* memo *********************************************************************/
+static void clear_memo(struct HashLife* life) {
+	memset(life->memo, 0, (life->memo_mask + 1) * sizeof(*life->memo));
+	life->memo_count = 0;
+}
+
+static struct Memo* find_memo(
+	struct HashLife* life, uint32_t node, uint32_t step
+) {
+	size_t slot = hash3(node, step, 0) & life->memo_mask;
+
+	for (;;) {
+		struct Memo* memo = &life->memo[slot];
+		if (memo->node == 0 || (memo->node == node && memo->step == step)) {
+			return memo;
+		}
+		slot = (slot + 1) & life->memo_mask;
+	}
+}
+
+static void store_memo(
+	struct HashLife* life, uint32_t node, uint32_t step, uint32_t result
+) {
+	/*
+	 * the memo doubles while it fits in half the limit, leaving the rest
+	 * to nodes, and is emptied once it does not
+	 */
+	if (life->memo_count >= (life->memo_mask + 1) / 2) {
+		size_t size = (life->memo_mask + 1) * sizeof(*life->memo);
+		struct Memo* memo = NULL;
+
+		if (
+			size * 2 <= life->memory_limit / 2
+			&& memory_used(life) + size <= life->memory_limit
+		) {
+			memo = calloc((life->memo_mask + 1) * 2, sizeof(*memo));
+		}
+
+		if (memo == NULL) {
+			clear_memo(life);
+			life->collections += 1;
+		} else {
+			struct Memo* old = life->memo;
+			size_t old_count = life->memo_mask + 1;
+
+			life->memo = memo;
+			life->memo_mask = (old_count * 2) - 1;
+			life->memo_count = 0;
+
+			for (size_t i = 0; i < old_count; ++i) {
+				if (old[i].node != 0) {
+					*find_memo(life, old[i].node, old[i].step) = old[i];
+					life->memo_count += 1;
+				}
+			}
+			free(old);
+		}
+	}
+
+	struct Memo* memo = find_memo(life, node, step);
+	if (memo->node == 0) {
+		life->memo_count += 1;
+	}
+	*memo = (struct Memo){node, step, result};
+}
+
+/* advancing ****************************************************************/
+static uint64_t step_cells(uint64_t c, uint8_t rule) {
+	uint64_t l = c << 1;
+	uint64_t r = c >> 1;
+	uint64_t next = 0;
+
+	/* neighbourhood `p` is left, centre, right from most significant bit */
+	for (int p = 0; p < 8; ++p) {
+		if ((rule >> p) & 1) {
+			next |= ((p & 4) ? l : ~l)
+			      & ((p & 2) ? c : ~c)
+			      & ((p & 1) ? r : ~r);
+		}
+	}
+
+	return next;
+}
+
+/* the centre half of a block of 2^k cells after 2^step generations */
+static uint32_t advance(struct HashLife* life, uint32_t id, uint32_t step) {
+	/* blocks are abandoned once the tables fill, to be advanced again */
+	if (life->full || life->failed || id == 0) {
+		return 0;
+	}
+
+	uint32_t level = life->nodes[id].level;
+
+	if (level == BASE_LEVEL) {
+		/* the outer 16 cells either side absorb any edge effects */
+		uint64_t cells = base_cells(life, id);
+		for (uint32_t t = 0; t < ((uint32_t)1 << step); ++t) {
+			cells = step_cells(cells, life->rule);
+		}
+		return leaf(life, cells >> 16);
+	}
+
+	struct Memo* memo = find_memo(life, id, step);
+	if (memo->node != 0) {
+		life->hits += 1;
+		return memo->result;
+	}
+	life->misses += 1;
+
+	/* the three overlapping halves of the block */
+	uint32_t left = life->nodes[id].left;
+	uint32_t right = life->nodes[id].right;
+	uint32_t middle = join(
+		life, life->nodes[left].right, life->nodes[right].left
+	);
+
+	/*
+	 * advancing the full 2^(k - 2) generations takes two half steps,
+	 * fewer generations are taken in the second step alone
+	 */
+	uint32_t r0, r1, r2, half;
+	if (step == level - 2) {
+		half = step - 1;
+		r0 = advance(life, left, half);
+		r1 = advance(life, middle, half);
+		r2 = advance(life, right, half);
+	} else {
+		half = step;
+		r0 = centre(life, left);
+		r1 = centre(life, middle);
+		r2 = centre(life, right);
+	}
+
+	uint32_t result = join(
+		life,
+		advance(life, join(life, r0, r1), half),
+		advance(life, join(life, r1, r2), half)
+	);
+
+	if (life->full || life->failed) {
+		return 0;
+	}
+
+	store_memo(life, id, step, result);
+	return result;
+}
+
+/* rows *********************************************************************/
+/* 32 cells starting at `position`, wrapping around the end of the row */
+static uint32_t get_leaf_cells(
+	const uint64_t* plane, size_t width, uint64_t position
+) {
+	size_t word = position / 64;
+	unsigned int offset = position % 64;
+
+	if (position + 32 <= width) {
+		uint64_t cells = plane[word] >> offset;
+		if (offset > 32) {
+			cells |= plane[word + 1] << (64 - offset);
+		}
+		return cells;
+	}
+
+	uint32_t cells = 0;
+	for (unsigned int k = 0; k < 32; ++k) {
+		cells |= (uint32_t)((plane[position / 64] >> (position % 64)) & 1) << k;
+		position = (position + 1 == width) ? 0 : position + 1;
+	}
+
+	return cells;
+}
+
+static bool grow_built(struct HashLife* life) {
+	size_t capacity = (life->built_mask + 1) * 2;
+	size_t size = capacity * sizeof(*life->built);
+	if (memory_used(life) + size > life->memory_limit) {
+		return false;
+	}
+
+	struct Built* built = calloc(capacity, sizeof(*built));
+	if (built == NULL) {
+		life->failed = true;
+		return false;
+	}
+
+	struct Built* old = life->built;
+	size_t old_capacity = life->built_mask + 1;
+
+	life->built = built;
+	life->built_mask = capacity - 1;
+
+	for (size_t i = 0; i < old_capacity; ++i) {
+		if (old[i].node == 0) {
+			continue;
+		}
+
+		size_t slot = hash3(old[i].level, old[i].offset, 1);
+		slot &= life->built_mask;
+		while (built[slot].node != 0) {
+			slot = (slot + 1) & life->built_mask;
+		}
+		built[slot] = old[i];
+	}
+
+	free(old);
+	return true;
+}
+
+/* the node of the block of 2^level cells starting at `offset` of a row */
+static uint32_t build(
+	struct HashLife* life, const uint64_t* plane, size_t width,
+	uint32_t level, uint64_t offset
+) {
+	if (level == LEAF_LEVEL) {
+		return leaf(life, get_leaf_cells(plane, width, offset));
+	}
+
+	/* blocks repeat along the row, each offset is only built once */
+	size_t slot = hash3(level, offset, 1) & life->built_mask;
+	while (life->built[slot].node != 0) {
+		const struct Built* built = &life->built[slot];
+		if (built->level == level && built->offset == offset) {
+			return built->node;
+		}
+		slot = (slot + 1) & life->built_mask;
+	}
+
+	uint64_t half = (uint64_t)1 << (level - 1);
+	uint32_t left = build(life, plane, width, level - 1, offset);
+	uint32_t right = build(
+		life, plane, width, level - 1, (offset + (half % width)) % width
+	);
+	uint32_t id = join(life, left, right);
+	if (id == 0) {
+		return 0;
+	}
+
+	/* blocks are built again rather than kept once the table is full */
+	if (
+		life->built_count >= (life->built_mask + 1) / 2
+		&& !grow_built(life)
+	) {
+		return id;
+	}
+
+	slot = hash3(level, offset, 1) & life->built_mask;
+	while (life->built[slot].node != 0) {
+		slot = (slot + 1) & life->built_mask;
+	}
+	life->built[slot] = (struct Built){offset, level, id};
+	life->built_count += 1;
+
+	return id;
+}
+
+/* writes the cells of a block into a row, stopping at the end of the row */
+static void flatten(
+	const struct HashLife* life, uint32_t id, uint64_t* plane, size_t width,
+	uint64_t position
+) {
+	if (position >= width) {
+		return;
+	}
+
+	const struct Node* node = &life->nodes[id];
+	if (node->level == LEAF_LEVEL) {
+		/* leaves start on a multiple of 32 cells */
+		uint64_t cells = node->left;
+		if (width - position < 32) {
+			cells &= ((uint64_t)1 << (width - position)) - 1;
+		}
+
+		uint64_t* word = &plane[position / 64];
+		unsigned int shift = position % 64;
+		*word = (*word & ~((uint64_t)0xffffffff << shift)) | (cells << shift);
+		return;
+	}
+
+	uint64_t half = (uint64_t)1 << (node->level - 1);
+	flatten(life, node->left, plane, width, position);
+	flatten(life, node->right, plane, width, position + half);
+}
+
+/* empties the node and memo tables, returning them to their initial size */
+static bool reset_tables(struct HashLife* life) {
+	free(life->memo);
+	free(life->node_slots);
+	free(life->nodes);
+
+	life->node_capacity = 1024;
+	life->node_count = 1;
+	life->nodes = malloc(life->node_capacity * sizeof(*life->nodes));
+	life->node_slot_mask = (life->node_capacity * 2) - 1;
+	life->node_slots = calloc(
+		life->node_slot_mask + 1, sizeof(*life->node_slots)
+	);
+
+	life->memo_count = 0;
+	life->memo_mask = 1023;
+	life->memo = calloc(life->memo_mask + 1, sizeof(*life->memo));
+
+	if (life->nodes == NULL || life->node_slots == NULL || life->memo == NULL) {
+		return false;
+	}
+
+	/* node 0 stands in for blocks which could not be stored */
+	life->nodes[0] = (struct Node){0, 0, LEAF_LEVEL};
+	return true;
+}
+
+static void clear_built(struct HashLife* life) {
+	memset(life->built, 0, (life->built_mask + 1) * sizeof(*life->built));
+	life->built_count = 0;
+}
+
+/* empties the tables once they are full, no node may be in use */
+static bool collect(struct HashLife* life) {
+	life->collections += 1;
+	life->epoch += 1;
+	life->full = false;
+	clear_built(life);
+
+	if (!reset_tables(life)) {
+		life->failed = true;
+		return false;
+	}
+	return true;
+}
+
+/*
+ * The largest step of a jump. Blocks are never wider than the smallest power
+ * of two covering the row, as a wider block of a repeating row only holds
+ * copies of it at other offsets, which share no nodes with one another. Longer
+ * jumps are taken by the row as a whole, see `ring_advance`.
+ */
+static uint32_t top_step(size_t width) {
+	uint32_t level = BASE_LEVEL;
+	while (((uint64_t)1 << level) < width) {
+		++level;
+	}
+	return level - 2;
+}
+
+/*
+ * Advances by 2^step generations, through `scratch`.
+ *
+ * - returns false if the tables filled up twice advancing one block.
+ */
+static bool jump(
+	struct HashLife* life, uint64_t* plane, uint64_t* scratch, size_t width,
+	uint32_t step
+) {
+	/* the smallest block which can be advanced 2^step generations */
+	uint32_t level = step + 2;
+	if (level < BASE_LEVEL) {
+		level = BASE_LEVEL;
+	}
+
+	clear_built(life);
+
+	uint64_t size = (uint64_t)1 << level;
+	uint64_t margin = size / 4;
+	uint64_t result_size = size / 2;
+
+	/*
+	 * each block yields the cells of its centre half, starting a quarter
+	 * of the block to the left of the cells it yields
+	 */
+	size_t result_count = (width + result_size - 1) / result_size;
+
+	/* flattened cells never reach past the row, which must stay clear */
+	scratch[eca_packed_words(width) - 1] = 0;
+
+	for (size_t i = 0; i < result_count; ++i) {
+		uint64_t position = i * result_size;
+		uint64_t offset = (position + width - (margin % width)) % width;
+
+		uint32_t block = build(life, plane, width, level, offset);
+		uint32_t result = advance(life, block, step);
+		if (life->full && collect(life)) {
+			block = build(life, plane, width, level, offset);
+			result = advance(life, block, step);
+		}
+		if (life->full || life->failed) {
+			return false;
+		}
+
+		flatten(life, result, scratch, width, position);
+	}
+
+	/* the row is only overwritten once every block has been read */
+	memcpy(plane, scratch, eca_packed_words(width) * sizeof(*plane));
+	return true;
+}
+
+/* steps the row directly, for rows whose blocks rarely repeat */
+static void step_directly(
+	struct HashLife* life, uint64_t* plane, uint64_t* scratch, size_t width,
+	uint64_t generations
+) {
+	if (eca_packed_linear(life->rule)) {
+		eca_packed_jump(plane, scratch, width, 1, &life->rule, generations);
+		return;
+	}
+
+	for (uint64_t t = 0; t < generations; ++t) {
+		eca_packed_generate(scratch, plane, width, 1, &life->rule);
+		memcpy(plane, scratch, eca_packed_words(width) * sizeof(*plane));
+	}
+}
+
+/* a jump too large for the tables is taken as two of half the size */
+static bool jump_within_limit(
+	struct HashLife* life, uint64_t* plane, uint64_t* scratch, size_t width,
+	uint32_t step
+) {
+	if (jump(life, plane, scratch, width, step)) {
+		return true;
+	}
+	if (life->failed || step == 0 || !collect(life)) {
+		life->failed = true;
+		return false;
+	}
+
+	return jump_within_limit(life, plane, scratch, width, step - 1)
+	    && jump_within_limit(life, plane, scratch, width, step - 1);
+}
+
+/* rings *******************************************************************/
+/*
+ * The row as a whole is one block of the widest level, from its first cell,
+ * so each state of the row is one node whatever its width, and its result
+ * after 2^step generations is memoised as any block's is, at steps too large
+ * for a block of that level to be advanced itself.
+ */
+struct Ring {
+	uint64_t* plane;
+	uint64_t* scratch;
+	size_t width;
+	uint32_t top;    /* step of one jump */
+	bool aligned;    /* the row is exactly one block, of more than 64 cells */
+	uint64_t epoch;  /* of the nodes held */
+	uint64_t done;   /* generations `plane` has been advanced by */
+	uint32_t current; /* node of `plane`, 0 if it is not built */
+};
+
+static uint32_t ring_node(struct HashLife* life, struct Ring* ring) {
+	clear_built(life);
+	uint32_t node = build(
+		life, ring->plane, ring->width, ring->top + 2, 0
+	);
+
+	ring->current = life->full ? 0 : node;
+	return ring->current;
+}
+
+/*
+ * One jump of a row which is exactly one block, from its nodes alone: the two
+ * blocks yielding each half of the row are made of its quarters, rotated.
+ *
+ * - returns 0 if the tables are full.
+ */
+static uint32_t ring_jump_nodes(
+	struct HashLife* life, uint32_t node, uint32_t step
+) {
+	const struct Node* left = &life->nodes[life->nodes[node].left];
+	const struct Node* right = &life->nodes[life->nodes[node].right];
+
+	uint32_t outer = join(life, right->right, left->left);
+	uint32_t inner = join(life, left->right, right->left);
+	uint32_t first = advance(life, join(life, outer, inner), step);
+	uint32_t second = advance(life, join(life, inner, outer), step);
+
+	return life->full ? 0 : join(life, first, second);
+}
+
+/*
+ * One jump of the row `node`, at `time`.
+ *
+ * - returns 0 if the nodes held were collected, or the jump missed too often
+ *   for hashing to pay off, `plane` is then the row after the jump.
+ */
+static uint32_t ring_jump(
+	struct HashLife* life, struct Ring* ring, uint32_t node, uint64_t time
+) {
+	uint64_t misses = life->misses;
+	uint64_t after = time + ((uint64_t)1 << ring->top);
+
+	uint32_t result = 0;
+	if (ring->aligned) {
+		result = ring_jump_nodes(life, node, ring->top);
+	}
+
+	/* otherwise taken on the row, where the tables may be emptied */
+	if (result == 0) {
+		if (node != ring->current) {
+			flatten(life, node, ring->plane, ring->width, 0);
+		}
+
+		bool ok = jump_within_limit(
+			life, ring->plane, ring->scratch, ring->width, ring->top
+		);
+		ring->done = after;
+		ring->current = 0;
+
+		if (!ok || life->epoch != ring->epoch) {
+			return 0;
+		}
+		result = ring_node(life, ring);
+	}
+
+	/* stepping directly costs a pass over the row a generation */
+	uint64_t direct_words = ((uint64_t)1 << ring->top)
+	                      * eca_packed_words(ring->width);
+	if ((life->misses - misses) * MISS_WORDS > direct_words) {
+		if (ring->done != after && result != 0) {
+			flatten(life, result, ring->plane, ring->width, 0);
+			ring->done = after;
+			ring->current = result;
+		}
+
+		life->direct = life->backoff;
+		if (life->backoff < MAX_BACKOFF) {
+			life->backoff *= 2;
+		}
+		return 0;
+	}
+
+	life->backoff = 1;
+	return result;
+}
+
+/* the row `node` at `time` after 2^step generations, 0 if interrupted */
+static uint32_t ring_advance(
+	struct HashLife* life, struct Ring* ring, uint32_t node, uint32_t step,
+	uint64_t time
+) {
+	if (node == 0 || life->failed || life->epoch != ring->epoch) {
+		return 0;
+	}
+	if (step == ring->top) {
+		return ring_jump(life, ring, node, time);
+	}
+
+	struct Memo* memo = find_memo(life, node, step);
+	if (memo->node != 0) {
+		life->hits += 1;
+		return memo->result;
+	}
+	life->misses += 1;
+
+	uint64_t half = (uint64_t)1 << (step - 1);
+	uint32_t middle = ring_advance(life, ring, node, step - 1, time);
+	uint32_t result = ring_advance(life, ring, middle, step - 1, time + half);
+	if (result == 0 || life->epoch != ring->epoch) {
+		return 0;
+	}
+
+	store_memo(life, node, step, result);
+	return result;
+}
+
+struct HashLife* hashlife_create(uint8_t rule, size_t memory_limit) {
+	struct HashLife* life = calloc(1, sizeof(*life));
+	if (life == NULL) {
+		return NULL;
+	}
+
+	life->rule = rule;
+	life->memory_limit = memory_limit;
+	life->backoff = 1;
+
+	life->built_mask = 1023;
+	life->built = calloc(life->built_mask + 1, sizeof(*life->built));
+
+	if (!reset_tables(life) || life->built == NULL) {
+		hashlife_destroy(life);
+		return NULL;
+	}
+
+	return life;
+}
+
+void hashlife_destroy(struct HashLife* life) {
+	free(life->built);
+	free(life->memo);
+	free(life->node_slots);
+	free(life->nodes);
+	free(life);
+}
+
+bool hashlife_advance(
+	struct HashLife* life, uint64_t* plane, size_t width,
+	uint64_t generations
+) {
+	size_t words = eca_packed_words(width);
+	uint32_t top = top_step(width);
+
+	uint64_t* scratch = malloc(words * sizeof(*scratch));
+	if (scratch == NULL) {
+		life->failed = true;
+		return false;
+	}
+
+	/* linear rules jump anywhere in a few passes, as in the packed engine */
+	if (eca_packed_linear(life->rule) && generations >= ECA_JUMP_STEPS) {
+		step_directly(life, plane, scratch, width, generations);
+		generations = 0;
+	}
+
+	/*
+	 * whole jumps are taken by the row as a whole, or stepped directly
+	 * while they miss more often than that would cost, trying again after
+	 * twice as many jumps each time
+	 */
+	struct Ring ring = {
+		plane, scratch, width, top,
+		width == (size_t)1 << (top + 2) && top + 2 > BASE_LEVEL, 0, 0, 0
+	};
+	uint64_t total = (generations >> top) << top;
+	bool fresh = false;
+
+	while (ring.done < total && !life->failed) {
+		uint64_t jumps = (total - ring.done) >> top;
+
+		if (life->direct > 0) {
+			uint64_t n = (life->direct < jumps) ? life->direct : jumps;
+			step_directly(life, plane, scratch, width, n << top);
+			life->direct -= n;
+			ring.done += n << top;
+			ring.current = 0;
+			continue;
+		}
+
+		if (life->full) {
+			fresh = collect(life);
+		}
+		ring.epoch = life->epoch;
+
+		uint32_t node = ring_node(life, &ring);
+		if (node == 0) {
+			/* the row alone does not fit in empty tables */
+			life->failed = life->failed || fresh;
+			continue;
+		}
+		fresh = false;
+
+		uint64_t time = ring.done;
+		for (uint32_t b = 64; b-- > 0 && node != 0;) {
+			if (((jumps >> b) & 1) != 0) {
+				node = ring_advance(life, &ring, node, top + b, time);
+				time += (uint64_t)1 << (top + b);
+			}
+		}
+
+		/* otherwise interrupted, and `plane` is left after the last jump */
+		if (node != 0) {
+			if (node != ring.current) {
+				flatten(life, node, plane, width, 0);
+			}
+			ring.done = total;
+		}
+	}
+
+	for (uint32_t step = top; step-- > 0 && !life->failed;) {
+		if (((generations >> step) & 1) != 0) {
+			jump_within_limit(life, plane, scratch, width, step);
+		}
+	}
+
+	free(scratch);
+	return !life->failed;
+}
+
+void hashlife_stats(const struct HashLife* life, struct HashLifeStats* stats) {
+	stats->nodes = life->node_count - 1;
+	stats->memo_entries = life->memo_count;
+	stats->memory = memory_used(life);
+	stats->hits = life->hits;
+	stats->misses = life->misses;
+	stats->collections = life->collections;
+}
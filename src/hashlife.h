@@ -0,0 +1,59 @@
+#ifndef HASHLIFE_H
+#define HASHLIFE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * A one dimensional HashLife engine.
+ *
+ * Rows are split into power of two blocks of cells, each stored once however
+ * often it occurs. The result of advancing a block, its centre half after
+ * 2^j generations, is memoised, so a block seen again costs a lookup, and
+ * jumping N generations takes one pass per set bit of N.
+ *
+ * The wrap around of a row of `width` cells is treated as an infinite row
+ * repeating every `width` cells. Blocks are no wider than the smallest power
+ * of two covering the row, longer jumps are made of remembered jumps of the
+ * whole row, and rows whose blocks rarely repeat are stepped directly, so a
+ * jump costs little more than stepping the row at worst, and far less for
+ * rows with regular structure.
+ *
+ * The tables are kept within `memory_limit` by emptying them, between blocks
+ * of a jump if need be.
+ */
+
+struct HashLife;
+
+struct HashLifeStats {
+	size_t nodes;        /* blocks currently stored */
+	size_t memo_entries; /* results currently memoised */
+	size_t memory;       /* bytes used by both tables */
+	uint64_t hits;       /* results found in the memo */
+	uint64_t misses;     /* results computed */
+	uint64_t collections; /* times the tables were emptied to fit the limit */
+};
+
+/**
+ * Creates an engine for `rule`, using up to about `memory_limit` bytes.
+ *
+ * - returns NULL on failure.
+ */
+struct HashLife* hashlife_create(uint8_t rule, size_t memory_limit);
+
+void hashlife_destroy(struct HashLife* life);
+
+/**
+ * Advances a packed plane of `width` cells by `generations`, in place.
+ *
+ * - returns false if memory could not be allocated.
+ */
+bool hashlife_advance(
+	struct HashLife* life, uint64_t* plane, size_t width,
+	uint64_t generations
+);
+
+void hashlife_stats(const struct HashLife* life, struct HashLifeStats* stats);
+
+#endif /* HASHLIFE_H */
@@ -0,0 +1,254 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "initial.h"
+
+#include "eca.h"
+#include "packed.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct Mapping {
+	const uint8_t* data;
+	size_t size;
+};
+
+static bool map_file(const char* filename, struct Mapping* mapping) {
+	mapping->data = NULL;
+	mapping->size = 0;
+
+	int fd = open(filename, O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0) {
+		fprintf(stderr, "error: could not read initial row %s\n", filename);
+		if (fd >= 0) {
+			close(fd);
+		}
+		return false;
+	}
+
+	void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (data == MAP_FAILED) {
+		fprintf(stderr, "error: could not map initial row %s\n", filename);
+		return false;
+	}
+
+	mapping->data = data;
+	mapping->size = st.st_size;
+	return true;
+}
+
+static void unmap_file(struct Mapping* mapping) {
+	munmap((void*)mapping->data, mapping->size);
+}
+
+static bool is_space(uint8_t c) {
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/* skips whitespace and comments, then reads a number */
+static bool pbm_number(const struct Mapping* mapping, size_t* at, size_t* n) {
+	const uint8_t* data = mapping->data;
+	size_t i = *at;
+
+	while (i < mapping->size && (data[i] == '#' || is_space(data[i]))) {
+		if (data[i] == '#') {
+			while (i < mapping->size && data[i] != '\n') {
+				++i;
+			}
+		} else {
+			++i;
+		}
+	}
+
+	size_t value = 0;
+	size_t first = i;
+	while (i < mapping->size && data[i] >= '0' && data[i] <= '9'
+	    && value <= INT32_MAX) {
+		value = (value * 10) + (data[i] - '0');
+		++i;
+	}
+
+	*at = i;
+	*n = value;
+	return i > first && value > 0 && value <= INT32_MAX;
+}
+
+/*
+ * The offset of the first row of a binary PBM, 0 if the file is not one.
+ *
+ * - `width` is 0 if the file is a PBM with a bad header.
+ */
+static size_t pbm_header(const struct Mapping* mapping, size_t* width) {
+	const uint8_t* data = mapping->data;
+	if (mapping->size < 2 || data[0] != 'P' || data[1] != '4') {
+		return 0;
+	}
+
+	/* a single whitespace character ends the header */
+	size_t at = 2;
+	size_t height = 0;
+	bool ok = pbm_number(mapping, &at, width)
+	       && pbm_number(mapping, &at, &height)
+	       && at < mapping->size && is_space(data[at]);
+
+	if (!ok || mapping->size - at - 1 < (*width + 7) / 8) {
+		*width = 0;
+	}
+	return at + 1;
+}
+
+bool initial_file_width(const char* filename, size_t* width) {
+	struct Mapping mapping;
+	if (!map_file(filename, &mapping)) {
+		return false;
+	}
+
+	size_t pbm_width = 0;
+	bool pbm = pbm_header(&mapping, &pbm_width) != 0;
+	size_t size = mapping.size;
+	unmap_file(&mapping);
+
+	if (pbm && pbm_width == 0) {
+		fprintf(stderr, "error: %s is not a binary PBM\n", filename);
+		return false;
+	}
+	if (!pbm && size < (*width + 7) / 8) {
+		fprintf(
+			stderr, "error: %s does not hold a row of %zu cells\n",
+			filename, *width
+		);
+		return false;
+	}
+	if (pbm) {
+		*width = pbm_width;
+	}
+
+	return true;
+}
+
+/* cells of a PBM are activated when black, the first in the highest bit */
+static bool read_file(
+	const char* filename, uint64_t* dst, size_t width, int plane_count
+) {
+	struct Mapping mapping;
+	if (!map_file(filename, &mapping)) {
+		return false;
+	}
+
+	size_t pbm_width = 0;
+	size_t offset = pbm_header(&mapping, &pbm_width);
+	size_t size = (width + 7) / 8;
+	bool pbm = offset != 0;
+
+	bool ok = pbm ? pbm_width == width : mapping.size >= size;
+	if (!ok) {
+		fprintf(
+			stderr, "error: %s does not hold a row of %zu cells\n",
+			filename, width
+		);
+		unmap_file(&mapping);
+		return false;
+	}
+
+	size_t words = eca_packed_words(width);
+	memset(dst, 0, words * sizeof(*dst));
+
+	const uint8_t* row = mapping.data + offset;
+	for (size_t i = 0; i < size; ++i) {
+		uint64_t byte = row[i];
+		if (pbm) {
+			/* reverse the bits of the byte */
+			byte = ((byte * 0x0202020202) & 0x010884422010) % 1023;
+		}
+		dst[i / 8] |= byte << ((i % 8) * 8);
+	}
+	unmap_file(&mapping);
+
+	if (width % 64 != 0) {
+		dst[words - 1] &= ((uint64_t)1 << (width % 64)) - 1;
+	}
+
+	for (int plane = 1; plane < plane_count; ++plane) {
+		memcpy(dst + (plane * words), dst, words * sizeof(*dst));
+	}
+
+	return true;
+}
+
+bool initial_packed(
+	const struct Options* options, uint64_t* dst, int plane_count
+) {
+	size_t width = options->width;
+
+	if (options->initial_file != NULL) {
+		return read_file(options->initial_file, dst, width, plane_count);
+	}
+
+	if (options->seeded && options->initial == INIT_RANDOM) {
+		eca_packed_initialise_seeded(
+			dst, width, plane_count, options->seed, options->density,
+			0, eca_packed_words(width)
+		);
+		return true;
+	}
+
+	switch (options->initial) {
+		default:
+		case INIT_STANDARD:
+			eca_packed_initialise(dst, width, plane_count);
+			break;
+		case INIT_ALTERNATE:
+			eca_packed_initialise_alternate(dst, width, plane_count);
+			break;
+		case INIT_RANDOM:
+			eca_packed_initialise_random(dst, width, plane_count);
+			break;
+	}
+
+	return true;
+}
+
+bool initial_bytes(
+	const struct Options* options, uint8_t* dst, int channel_count
+) {
+	size_t width = options->width;
+	bool fixed = options->initial_file == NULL
+	          && !(options->seeded && options->initial == INIT_RANDOM);
+
+	if (fixed) {
+		switch (options->initial) {
+			default:
+			case INIT_STANDARD:
+				eca_initialise(dst, width, channel_count);
+				break;
+			case INIT_ALTERNATE:
+				eca_initialise_alternate(dst, width, channel_count);
+				break;
+			case INIT_RANDOM:
+				eca_initialise_random(dst, width, channel_count);
+				break;
+		}
+		return true;
+	}
+
+	/* other rows are made packed, then expanded a cell at a time */
+	uint64_t* packed = malloc(eca_packed_words(width) * sizeof(*packed));
+	bool ok = packed != NULL && initial_packed(options, packed, 1);
+
+	for (size_t i = 0; ok && i < width; ++i) {
+		bool on = (packed[i / 64] >> (i % 64)) & 1;
+		uint8_t val = on ? ECA_ON : ECA_OFF;
+		memset(dst + (i * channel_count), val, channel_count);
+	}
+
+	free(packed);
+	return ok;
+}
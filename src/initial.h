@@ -0,0 +1,47 @@
+#ifndef INITIAL_H
+#define INITIAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "options.h"
+
+/*
+ * The first generation of a run: one of the fixed patterns of `-i`, a random
+ * row from a seed and density (see `eca_packed_initialise_seeded`), or a row
+ * read from a file.
+ *
+ * Files are mapped rather than read, and may be a binary PBM, whose first row
+ * is used, or a bitfile of packed cells, with cell `i` in bit `i % 8` of byte
+ * `i / 8`, as the packed engine stores them on a little endian machine.
+ */
+
+/**
+ * Sets `width` to that of the PBM `filename`, other files are left to `-W`.
+ *
+ * - prints why and returns false if the file can not be read, or is too short
+ *   for a row of `width` cells.
+ */
+bool initial_file_width(const char* filename, size_t* width);
+
+/**
+ * Populates the packed first generation of `options`, every plane is set
+ * identically.
+ *
+ * - prints why and returns false if the file can not be read.
+ */
+bool initial_packed(
+	const struct Options* options, uint64_t* dst, int plane_count
+);
+
+/**
+ * Populates the first generation of `options` as pixels, see `eca.h`.
+ *
+ * - prints why and returns false if the file can not be read.
+ */
+bool initial_bytes(
+	const struct Options* options, uint8_t* dst, int channel_count
+);
+
+#endif /* INITIAL_H */
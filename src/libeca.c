@@ -0,0 +1,235 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "libeca.h"
+
+#include "packed.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+struct EcaContext {
+	struct EcaConfig config;
+	eca_packed_init_fn* init_fn;
+	eca_packed_gen_fn* gen_fn;
+	eca_packed_range_fn* range_fn;
+	int plane_count;
+	int jump_planes; /* planes of linear rules, see `eca_packed_jump` */
+	size_t words;
+
+	uint64_t* current;
+	uint64_t* next;
+	uint64_t generation;
+
+	bool allocated;
+};
+
+/* `size` rounded up to a whole number of `ECA_ALIGNMENT` */
+static size_t align_size(size_t size) {
+	return (size + ECA_ALIGNMENT - 1) & ~(size_t)(ECA_ALIGNMENT - 1);
+}
+
+static int plane_count(enum EcaMode mode) {
+	switch (mode) {
+		case ECA_MODE_STANDARD:    return ECA_PLANES_STANDARD;
+		case ECA_MODE_SPLIT:       return ECA_PLANES_SPLIT;
+		case ECA_MODE_DIRECTIONAL: return ECA_PLANES_DIRECTIONAL;
+		default:                   return 0;
+	}
+}
+
+static eca_packed_init_fn* init_fn(enum EcaInitial initial) {
+	switch (initial) {
+		case ECA_INITIAL_STANDARD:  return eca_packed_initialise;
+		case ECA_INITIAL_ALTERNATE: return eca_packed_initialise_alternate;
+		case ECA_INITIAL_RANDOM:    return eca_packed_initialise_random;
+		default:                    return NULL;
+	}
+}
+
+static eca_packed_gen_fn* gen_fn(enum EcaMode mode) {
+	switch (mode) {
+		case ECA_MODE_SPLIT:       return eca_packed_generate_split;
+		case ECA_MODE_DIRECTIONAL: return eca_packed_generate_directional;
+		default:                   return eca_packed_generate;
+	}
+}
+
+static eca_packed_range_fn* range_fn(enum EcaMode mode) {
+	switch (mode) {
+		case ECA_MODE_SPLIT:
+			return eca_packed_generate_split_range;
+		case ECA_MODE_DIRECTIONAL:
+			return eca_packed_generate_directional_range;
+		default:
+			return eca_packed_generate_range;
+	}
+}
+
+/*
+ * Only the state plane of directional mode jumps, its parents are found again
+ * by the generation which follows.
+ */
+static int jump_planes(const struct EcaConfig* config) {
+	const uint8_t* rules = config->rules;
+
+	switch (config->mode) {
+		case ECA_MODE_STANDARD:
+		case ECA_MODE_DIRECTIONAL:
+			return eca_packed_linear(rules[0]) ? 1 : 0;
+		case ECA_MODE_SPLIT:
+			return (eca_packed_linear(rules[0]) && eca_packed_linear(rules[1])
+			     && eca_packed_linear(rules[2])) ? ECA_PLANES_SPLIT : 0;
+		default:
+			return 0;
+	}
+}
+
+/* bytes of one row of every plane, before alignment */
+static size_t row_size(const struct EcaConfig* config) {
+	return eca_packed_words(config->width) * plane_count(config->mode)
+	     * sizeof(uint64_t);
+}
+
+size_t eca_context_size(const struct EcaConfig* config) {
+	if (config->width == 0 || config->width > (SIZE_MAX >> 4)
+	 || plane_count(config->mode) == 0 || init_fn(config->initial) == NULL) {
+		return 0;
+	}
+
+	return align_size(sizeof(struct EcaContext))
+	     + (2 * align_size(row_size(config)));
+}
+
+struct EcaContext* eca_context_create(
+	const struct EcaConfig* config, void* memory, size_t size
+) {
+	size_t needed = eca_context_size(config);
+	if (needed == 0) {
+		return NULL;
+	}
+
+	bool allocated = memory == NULL;
+	if (allocated) {
+		if (posix_memalign(&memory, ECA_ALIGNMENT, needed) != 0) {
+			return NULL;
+		}
+	} else if (size < needed || (uintptr_t)memory % ECA_ALIGNMENT != 0) {
+		return NULL;
+	}
+
+	/* the context is followed by its two rows */
+	uint8_t* base = memory;
+	size_t header = align_size(sizeof(struct EcaContext));
+	size_t row = align_size(row_size(config));
+
+	struct EcaContext* context = memory;
+	*context = (struct EcaContext){
+		.config = *config,
+		.init_fn = init_fn(config->initial),
+		.gen_fn = gen_fn(config->mode),
+		.range_fn = range_fn(config->mode),
+		.plane_count = plane_count(config->mode),
+		.jump_planes = jump_planes(config),
+		.words = eca_packed_words(config->width),
+		.current = (uint64_t*)(base + header),
+		.next = (uint64_t*)(base + header + row),
+		.allocated = allocated
+	};
+
+	eca_context_reset(context, NULL);
+
+	return context;
+}
+
+void eca_context_destroy(struct EcaContext* context) {
+	if (context != NULL && context->allocated) {
+		free(context);
+	}
+}
+
+void eca_context_reset(struct EcaContext* context, const uint64_t* row) {
+	if (row != NULL) {
+		size_t size = context->words * context->plane_count * sizeof(*row);
+		memcpy(context->current, row, size);
+	} else {
+		context->init_fn(
+			context->current, context->config.width, context->plane_count
+		);
+	}
+
+	context->generation = 0;
+}
+
+/* advances every tile of the row by up to `ECA_TILE_STEPS` generations */
+static void step_tiles(struct EcaContext* context, int steps) {
+	uint64_t* dst[ECA_TILE_STEPS] = {NULL};
+	dst[steps - 1] = context->next;
+
+	for (size_t begin = 0; begin < context->words; begin += ECA_TILE_WORDS) {
+		size_t end = begin + ECA_TILE_WORDS;
+		if (end > context->words) {
+			end = context->words;
+		}
+
+		eca_packed_advance_tile(
+			dst, context->current, context->config.width,
+			context->plane_count, context->config.rules, context->range_fn,
+			begin, end, steps
+		);
+	}
+}
+
+void eca_context_step(struct EcaContext* context, uint64_t steps) {
+	/* only rows which outgrow a tile gain from staying in cache */
+	bool tiled = context->words > ECA_TILE_WORDS;
+
+	/* linear rules skip straight to the last generation */
+	if (context->jump_planes > 0 && steps > ECA_JUMP_STEPS) {
+		eca_packed_jump(
+			context->current, context->next, context->config.width,
+			context->jump_planes, context->config.rules, steps - 1
+		);
+		context->generation += steps - 1;
+		steps = 1;
+	}
+
+	while (steps > 0) {
+		int count = 1;
+		if (tiled) {
+			count = (steps < ECA_TILE_STEPS) ? steps : ECA_TILE_STEPS;
+			step_tiles(context, count);
+		} else {
+			context->gen_fn(
+				context->next, context->current, context->config.width,
+				context->plane_count, context->config.rules
+			);
+		}
+
+		uint64_t* tmp = context->current;
+		context->current = context->next;
+		context->next = tmp;
+
+		context->generation += count;
+		steps -= count;
+	}
+}
+
+const uint64_t* eca_context_row(const struct EcaContext* context) {
+	return context->current;
+}
+
+uint64_t eca_context_generation(const struct EcaContext* context) {
+	return context->generation;
+}
+
+size_t eca_context_words(const struct EcaContext* context) {
+	return context->words;
+}
+
+int eca_context_planes(const struct EcaContext* context) {
+	return context->plane_count;
+}
+
+bool eca_context_cell(const struct EcaContext* context, size_t index) {
+	return (context->current[index / 64] >> (index % 64)) & 1;
+}
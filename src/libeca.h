@@ -0,0 +1,132 @@
+#ifndef LIBECA_H
+#define LIBECA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * libeca wraps the packed engine in a context of its own, for programs which
+ * embed the automata rather than run `wolfram`. A context holds everything a
+ * simulation needs, so any number may be used at once, one per thread.
+ *
+ * All memory is set aside when a context is created, either by the caller or
+ * by `eca_context_create`, and stepping never allocates.
+ *
+ * Rows are packed as in the packed engine, one bit per cell and 64 cells to a
+ * word. Cell `i` is bit `i % 64` of word `i / 64`, and unused bits of the
+ * final word are clear. A row has one plane of `eca_context_words` words per
+ * channel of the mode, stored one after another: 1 in standard mode, 3 in
+ * split mode (one per rule), and 4 in directional mode (the cell state, then
+ * the left, centre, and right parent states of each activated cell).
+ */
+
+/*
+ * Marks the functions the shared library exports, which is built with every
+ * other symbol hidden so the engine's own names cannot clash with a host's.
+ */
+#if defined(__GNUC__)
+#define ECA_EXPORT __attribute__((visibility("default")))
+#else
+#define ECA_EXPORT
+#endif
+
+/* alignment of the memory given to `eca_context_create`, and of its rows */
+#define ECA_ALIGNMENT 64
+
+enum EcaMode {
+	ECA_MODE_STANDARD    = 1,
+	ECA_MODE_SPLIT       = 2,
+	ECA_MODE_DIRECTIONAL = 3
+};
+
+enum EcaInitial {
+	ECA_INITIAL_STANDARD  = 1,
+	ECA_INITIAL_ALTERNATE = 2,
+	ECA_INITIAL_RANDOM    = 3
+};
+
+struct EcaConfig {
+	size_t width;
+	enum EcaMode mode;
+	enum EcaInitial initial;
+	uint8_t rules[3]; /* only split mode uses the second and third */
+};
+
+struct EcaContext;
+
+/**
+ * The bytes of memory needed for a context of `config`.
+ *
+ * - returns 0 if `config` is invalid.
+ */
+ECA_EXPORT size_t eca_context_size(const struct EcaConfig* config);
+
+/**
+ * Creates a context at its initial generation.
+ *
+ * - `memory` must be aligned to `ECA_ALIGNMENT` and at least
+ *   `eca_context_size(config)` bytes, it is owned by the context until it
+ *   is destroyed.
+ * - `memory` may be NULL to allocate it instead.
+ * - returns NULL if `config` is invalid, `memory` is too small or
+ *   misaligned, or it could not be allocated.
+ */
+ECA_EXPORT struct EcaContext* eca_context_create(
+	const struct EcaConfig* config, void* memory, size_t size
+);
+
+/**
+ * Frees the memory of `context` if it was allocated by `eca_context_create`.
+ */
+ECA_EXPORT void eca_context_destroy(struct EcaContext* context);
+
+/**
+ * Returns to generation 0, either the initial generation of the config or
+ * a copy of `row`.
+ *
+ * - `row` may be NULL, or a packed row of every plane of the mode.
+ */
+ECA_EXPORT void eca_context_reset(
+	struct EcaContext* context, const uint64_t* row
+);
+
+/**
+ * Advances by `steps` generations.
+ *
+ * - rows wider than the cache are advanced in tiles, up to 64 generations
+ *   at a time.
+ * - linear rules, such as 90 and 150, jump ahead in `log2(steps)` passes.
+ */
+ECA_EXPORT void eca_context_step(struct EcaContext* context, uint64_t steps);
+
+/**
+ * The packed row of the current generation.
+ *
+ * - valid until the next step or reset.
+ */
+ECA_EXPORT const uint64_t* eca_context_row(const struct EcaContext* context);
+
+/**
+ * The number of generations since the last reset.
+ */
+ECA_EXPORT uint64_t eca_context_generation(const struct EcaContext* context);
+
+/**
+ * The number of words in each plane of a row.
+ */
+ECA_EXPORT size_t eca_context_words(const struct EcaContext* context);
+
+/**
+ * The number of planes in each row.
+ */
+ECA_EXPORT int eca_context_planes(const struct EcaContext* context);
+
+/**
+ * Whether cell `index` of the first plane is activated.
+ */
+ECA_EXPORT bool eca_context_cell(
+	const struct EcaContext* context, size_t index
+);
+
+#endif /* LIBECA_H */
@@ -0,0 +1,205 @@
+#include "live.h"
+
+#include "palette.h"
+#include "render.h"
+#include "stats.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* frames of rows in flight, the GPU may still be reading the others */
+#define FRAME_COUNT 3
+
+/* how long to wait for the GPU to finish with a section of the buffer */
+static const GLuint64 fence_timeout = 1000000000;
+
+struct Live {
+	GLFWwindow* window;
+	GLuint program;
+	GLuint vao;
+	GLuint texture;
+	GLuint pbo;
+	GLint offset_location;
+
+	uint8_t* mapped;              /* the persistently mapped pixel buffer */
+	GLsync fences[FRAME_COUNT];   /* set once the GPU has read a section */
+
+	size_t width;
+	size_t height;                /* rows in the ring */
+	size_t row_size;
+	size_t frame_rows;            /* rows generated for each frame */
+
+	int frame;                    /* the section being filled */
+	size_t filled;                /* rows of the section filled */
+	size_t head;                  /* the oldest row of the ring */
+
+	bool closed;
+};
+
+/* waits until the GPU has finished reading the section being filled */
+static bool wait_frame(struct Live* live) {
+	GLsync fence = live->fences[live->frame];
+	if (fence == NULL) {
+		return true;
+	}
+
+	GLenum status = glClientWaitSync(
+		fence, GL_SYNC_FLUSH_COMMANDS_BIT, fence_timeout
+	);
+	glDeleteSync(fence);
+	live->fences[live->frame] = NULL;
+
+	return status != GL_TIMEOUT_EXPIRED && status != GL_WAIT_FAILED;
+}
+
+/* copies the filled rows into the ring, and draws it */
+static bool present(struct Live* live) {
+	uint64_t begin = stats_clock();
+
+	size_t section = live->frame * live->frame_rows * live->row_size;
+	size_t first = live->height - live->head;
+	if (first > live->filled) {
+		first = live->filled;
+	}
+
+	/* the rows wrap around to the top of the ring */
+	glBindTexture(GL_TEXTURE_2D, live->texture);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, live->pbo);
+	glTexSubImage2D(
+		GL_TEXTURE_2D, 0, 0, live->head, live->width, first,
+		GL_RGB, GL_UNSIGNED_BYTE, (void*)section
+	);
+	if (first < live->filled) {
+		glTexSubImage2D(
+			GL_TEXTURE_2D, 0, 0, 0, live->width, live->filled - first,
+			GL_RGB, GL_UNSIGNED_BYTE,
+			(void*)(section + (first * live->row_size))
+		);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	live->fences[live->frame] = glFenceSync(
+		GL_SYNC_GPU_COMMANDS_COMPLETE, 0
+	);
+	live->head = (live->head + live->filled) % live->height;
+	stats_end(STATS_UPLOAD, begin);
+
+	glClear(GL_COLOR_BUFFER_BIT);
+	glUseProgram(live->program);
+	glUniform1f(live->offset_location, (float)live->head / live->height);
+	glBindVertexArray(live->vao);
+	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_BYTE, NULL);
+
+	glfwSwapBuffers(live->window);
+	glfwPollEvents();
+	live->closed = glfwWindowShouldClose(live->window);
+
+	live->frame = (live->frame + 1) % FRAME_COUNT;
+	live->filled = 0;
+
+	return wait_frame(live);
+}
+
+static bool live_row(void* context, const uint8_t* row, size_t index) {
+	struct Live* live = context;
+	(void)index;
+
+	size_t section = live->frame * live->frame_rows;
+	uint8_t* dst = live->mapped
+	             + ((section + live->filled) * live->row_size);
+	memcpy(dst, row, live->row_size);
+	live->filled += 1;
+
+	if (live->filled == live->frame_rows && !present(live)) {
+		fprintf(stderr, "error: timed out waiting for the GPU\n");
+		return false;
+	}
+
+	/* stops rendering once the window is closed */
+	return !live->closed;
+}
+
+bool live_run(
+	const struct Options* options, GLFWwindow* window,
+	GLuint program, GLuint vao
+) {
+	if (!GLAD_GL_VERSION_4_4) {
+		fprintf(stderr, "error: the live view needs OpenGL 4.4\n");
+		return false;
+	}
+
+	struct Live live = {
+		.window = window,
+		.program = program,
+		.vao = vao,
+		.offset_location = glGetUniformLocation(program, "offset"),
+		.width = options->width,
+		.height = options->height,
+		.row_size = palette_row_size(FORMAT_RGB, options->width),
+		.frame_rows = options->live
+	};
+
+	/* only the last ring of rows generated in a frame would be seen */
+	if (live.frame_rows > live.height) {
+		live.frame_rows = live.height;
+	}
+
+	/* the ring starts out as the background of the palette */
+	struct Palette palette;
+	render_palette(&palette, options->mode);
+
+	glGenTextures(1, &live.texture);
+	glBindTexture(GL_TEXTURE_2D, live.texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGB8, live.width, live.height);
+	glClearTexImage(
+		live.texture, 0, GL_RGB, GL_UNSIGNED_BYTE, palette.rgb[0]
+	);
+
+	/* rows are tightly packed, whatever the width */
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	GLsizeiptr size = FRAME_COUNT * live.frame_rows * live.row_size;
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT
+	                 | GL_MAP_COHERENT_BIT;
+
+	glGenBuffers(1, &live.pbo);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, live.pbo);
+	glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, NULL, flags);
+	live.mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	bool ok = live.mapped != NULL;
+	if (!ok) {
+		fprintf(stderr, "error: could not map the pixel buffer\n");
+	}
+
+	/* generations go on until the window is closed */
+	struct Options endless = *options;
+	endless.height = (UINT64_MAX - options->start) / options->stride;
+
+	if (ok) {
+		glfwSwapInterval(1);
+		ok = render(&endless, &palette, FORMAT_RGB, live_row, &live)
+		  || live.closed;
+	}
+
+	for (int n = 0; n < FRAME_COUNT; ++n) {
+		if (live.fences[n] != NULL) {
+			glDeleteSync(live.fences[n]);
+		}
+	}
+	if (live.mapped != NULL) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, live.pbo);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+	glDeleteBuffers(1, &live.pbo);
+	glDeleteTextures(1, &live.texture);
+
+	return ok;
+}
@@ -0,0 +1,36 @@
+#ifndef LIVE_H
+#define LIVE_H
+
+#include <stdbool.h>
+
+#include "glad/gl.h"
+#include <GLFW/glfw3.h>
+
+#include "options.h"
+
+/*
+ * The live view keeps generating while the window is open, scrolling the
+ * newest generation up from the bottom of the window.
+ *
+ * The window shows a ring of `options->height` rows held in one texture.
+ * Each frame, `options->live` new rows are coloured straight into a
+ * persistently mapped pixel buffer, which has a section for each of a few
+ * frames in flight, and only those rows are copied into the texture with
+ * `glTexSubImage2D`. The oldest row of the ring is passed to the vertex
+ * shader as `offset`, which wraps the texture around to scroll it, so rows
+ * are never moved once uploaded.
+ */
+
+/**
+ * Runs until the window is closed, drawing the quad of `vao` with
+ * `program`, which samples `texture0` from `f_tex_coords + offset`.
+ *
+ * - needs OpenGL 4.4 for persistently mapped buffers.
+ * - returns false if the buffers could not be created or rendering failed.
+ */
+bool live_run(
+	const struct Options* options, GLFWwindow* window,
+	GLuint program, GLuint vao
+);
+
+#endif /* LIVE_H */
@@ -0,0 +1,239 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "lut.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <string.h>
+
+/*
+ * Bit `k` of a window is cell `i - 1 + k`, and bit `m` of an entry is the
+ * next state of cell `i + m`.
+ */
+static uint8_t tables[256][1024];
+static bool built[256];
+static pthread_mutex_t build_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void eca_lut_prepare(const uint8_t* rules, int rule_count) {
+	pthread_mutex_lock(&build_lock);
+
+	for (int n = 0; n < rule_count; ++n) {
+		uint8_t rule = rules[n];
+		if (built[rule]) {
+			continue;
+		}
+
+		for (unsigned int window = 0; window < 1024; ++window) {
+			uint8_t next = 0;
+			for (int m = 0; m < 8; ++m) {
+				unsigned int rule_index = (window >> m) & 7;
+				/* the left cell is the least significant bit */
+				rule_index = ((rule_index & 1) << 2)
+				           | (rule_index & 2)
+				           | ((rule_index & 4) >> 2);
+				next |= ((rule >> rule_index) & 1) << m;
+			}
+			tables[rule][window] = next;
+		}
+
+		built[rule] = true;
+	}
+
+	pthread_mutex_unlock(&build_lock);
+}
+
+/* 0x7f in each byte, and 0x80 in each byte */
+#define LOW_BITS  0x7f7f7f7f7f7f7f7fULL
+#define HIGH_BITS 0x8080808080808080ULL
+
+/* ECA_HALF in each byte */
+#define HALF_BYTES (ECA_HALF * 0x0101010101010101ULL)
+
+/* a channel of eight cells from `src`, cell `k` in byte `k` */
+static inline uint64_t load_channel(
+	const uint8_t* src, int channel_count, int channel
+) {
+	uint64_t bytes = 0;
+	for (int k = 0; k < 8; ++k) {
+		bytes |= (uint64_t)src[(k * channel_count) + channel] << (8 * k);
+	}
+
+	return bytes;
+}
+
+/* gathers the top bit of each byte into bit `k` for byte `k` */
+static inline unsigned int pack_high_bits(uint64_t bytes) {
+	return (((bytes & HIGH_BITS) >> 7) * 0x0102040810204080ULL) >> 56;
+}
+
+/* the top bit of each byte which is not zero */
+static inline uint64_t nonzero_bytes(uint64_t bytes) {
+	return ((bytes & LOW_BITS) + LOW_BITS) | bytes;
+}
+
+/* sets every bit of byte `k` to bit `k` of the low byte of `bits` */
+static inline uint64_t spread_bits(unsigned int bits) {
+	uint64_t bytes = ((bits & 0xff) * 0x0101010101010101ULL)
+	               & 0x8040201008040201ULL;
+	return ((nonzero_bytes(bytes) & HIGH_BITS) >> 7) * 0xff;
+}
+
+/*
+ * Eight cells of a single channel starting at cell `i`, bit `k` set if cell
+ * `i + k` is on, or if any channel of it is set when `channel` is negative.
+ * Cells past the end of the row wrap around to its start.
+ */
+static inline unsigned int cell_group(
+	const uint8_t* src, size_t width, int channel_count, size_t i,
+	int channel
+) {
+	/* one cell at a time across the edge */
+	if (i + 8 > width) {
+		unsigned int group = 0;
+		for (int k = 0; k < 8; ++k) {
+			const uint8_t* cell = src + (((i + k) % width) * channel_count);
+
+			bool on = channel >= 0 && cell[channel] == ECA_ON;
+			for (int n = 0; channel < 0 && n < channel_count; ++n) {
+				on = on || cell[n] != ECA_OFF;
+			}
+			group |= (unsigned int)on << k;
+		}
+		return group;
+	}
+
+	src += i * channel_count;
+	if (channel >= 0) {
+		/* ECA_ON bytes are zero once inverted */
+		uint64_t bytes = ~load_channel(src, channel_count, channel);
+		return pack_high_bits(~nonzero_bytes(bytes));
+	}
+
+	uint64_t any = 0;
+	for (int n = 0; n < channel_count; ++n) {
+		any |= load_channel(src, channel_count, n);
+	}
+	return pack_high_bits(nonzero_bytes(any));
+}
+
+/*
+ * The window of the group of cells at `i`, from `left`, whose top bit is the
+ * cell before it, and `group`, its cells, which both move on to the next.
+ */
+static inline unsigned int next_window(
+	const uint8_t* src, size_t width, int channel_count, size_t i,
+	int channel, unsigned int* left, unsigned int* group
+) {
+	unsigned int next = cell_group(src, width, channel_count, i + 8, channel);
+	unsigned int window = ((*left >> 7) & 1) | (*group << 1)
+	                    | ((next & 1) << 9);
+
+	*left = *group;
+	*group = next;
+	return window;
+}
+
+/* the cells before and of the first group, starting with the last cell */
+#define FIRST_GROUPS(channel) \
+	unsigned int left = cell_group( \
+		src, width, channel_count, width - 1, (channel) \
+	) << 7; \
+	unsigned int group = cell_group(src, width, channel_count, 0, (channel))
+
+static inline void generate_lut(
+	uint8_t* dst, const uint8_t* src, size_t width, int channel_count,
+	uint8_t rules[channel_count]
+) {
+	const uint8_t* table = tables[rules[0]];
+
+	FIRST_GROUPS(0);
+	for (size_t i = 0; i < width; i += 8) {
+		unsigned int window = next_window(
+			src, width, channel_count, i, 0, &left, &group
+		);
+
+		/* every cell is written, which avoids branching on each */
+		uint64_t states = spread_bits(table[window]);
+		size_t count = (width - i < 8) ? width - i : 8;
+
+		uint8_t* pixel = dst + (i * channel_count);
+		for (size_t m = 0; m < count; ++m) {
+			for (int channel = 0; channel < channel_count; ++channel) {
+				pixel[(m * channel_count) + channel] = states >> (8 * m);
+			}
+		}
+	}
+}
+
+static inline void generate_split_lut(
+	uint8_t* dst, const uint8_t* src, size_t width, int channel_count,
+	uint8_t rules[channel_count]
+) {
+	for (int channel = 0; channel < 3; ++channel) {
+		const uint8_t* table = tables[rules[channel]];
+
+		FIRST_GROUPS(channel);
+		for (size_t i = 0; i < width; i += 8) {
+			unsigned int window = next_window(
+				src, width, channel_count, i, channel, &left, &group
+			);
+
+			uint64_t states = spread_bits(table[window]);
+			size_t count = (width - i < 8) ? width - i : 8;
+
+			uint8_t* pixel = dst + (i * channel_count) + channel;
+			for (size_t m = 0; m < count; ++m) {
+				pixel[m * channel_count] = states >> (8 * m);
+			}
+		}
+	}
+}
+
+static inline void generate_directional_lut(
+	uint8_t* dst, const uint8_t* src, size_t width, int channel_count,
+	uint8_t rules[channel_count]
+) {
+	const uint8_t* table = tables[rules[0]];
+
+	FIRST_GROUPS(-1);
+	for (size_t i = 0; i < width; i += 8) {
+		unsigned int window = next_window(
+			src, width, channel_count, i, -1, &left, &group
+		);
+
+		/* the channels of all eight cells at once, cell `m` in byte `m` */
+		uint64_t on = spread_bits(table[window]);
+		size_t count = (width - i < 8) ? width - i : 8;
+
+		for (int channel = 0; channel < 3; ++channel) {
+			/* parents are bits m, m + 1 and m + 2 of the window */
+			uint64_t parent = spread_bits(window >> channel);
+			uint64_t states = on & (parent | (~parent & HALF_BYTES));
+
+			uint8_t* pixel = dst + (i * channel_count) + channel;
+			for (size_t m = 0; m < count; ++m) {
+				pixel[m * channel_count] = states >> (8 * m);
+			}
+		}
+	}
+}
+
+/*
+ * Each kernel is inlined for three channels, as the renderer uses, so that
+ * cells are gathered and written with constant strides.
+ */
+#define SPECIALISE(kernel, body) \
+	void kernel( \
+		uint8_t* dst, const uint8_t* src, size_t width, int channel_count, \
+		uint8_t rules[channel_count] \
+	) { \
+		if (channel_count == 3) { \
+			body(dst, src, width, 3, rules); \
+		} else { \
+			body(dst, src, width, channel_count, rules); \
+		} \
+	}
+
+SPECIALISE(eca_generate_lut, generate_lut)
+SPECIALISE(eca_generate_split_lut, generate_split_lut)
+SPECIALISE(eca_generate_directional_lut, generate_directional_lut)
@@ -0,0 +1,50 @@
+#ifndef LUT_H
+#define LUT_H
+
+#include "eca.h"
+
+#include <stdint.h>
+
+/*
+ * Table driven kernels for the byte layout.
+ *
+ * Each table maps a 10 cell window (8 cells and their outer neighbours) to the
+ * next state of the 8 inner cells, one byte per entry. A table is 1 KiB, so
+ * the three used by split mode still fit comfortably within the L1 cache.
+ */
+
+/**
+ * Builds the tables for the given rules, this must be called before any of
+ * the rules are passed to a `eca_generate*_lut` function.
+ *
+ * - tables which already exist are not rebuilt.
+ * - may be called from several threads at once.
+ */
+void eca_lut_prepare(const uint8_t* rules, int rule_count);
+
+/**
+ * Standard generation, see `eca_generate`.
+ */
+void eca_generate_lut(
+	uint8_t* dst, const uint8_t* src, size_t width, int channel_count,
+	uint8_t rules[channel_count]
+);
+
+/**
+ * Each channel is treated individially, see `eca_generate_split`.
+ */
+void eca_generate_split_lut(
+	uint8_t* dst, const uint8_t* src, size_t width, int channel_count,
+	uint8_t rules[channel_count]
+);
+
+/**
+ * Cells are coloured depending on which parents are activated, see
+ * `eca_generate_directional`.
+ */
+void eca_generate_directional_lut(
+	uint8_t* dst, const uint8_t* src, size_t width, int channel_count,
+	uint8_t rules[channel_count]
+);
+
+#endif /* LUT_H */
@@ -1,3 +1,4 @@
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -6,13 +7,18 @@
 #include "glad/gl.h"
 #include <GLFW/glfw3.h>
 
-#include "stb/stb_image_write.h"
-
+#include "batch.h"
+#include "checkpoint.h"
+#include "initial.h"
 #include "eca.h"
 #include "options.h"
+#include "live.h"
+#include "render.h"
+#include "stats.h"
 
-static const int window_width  = 640;
-static const int window_height = 480;
+/* largest window opened, larger canvases are scaled down to fit */
+static const int max_window_width  = 1280;
+static const int max_window_height = 960;
 static const int channel_count = 3;
 static const char* title = "elementary cellular automata";
 
@@ -21,20 +27,27 @@ enum StatusCode {
 	RV_BAD_ARGS,
 	RV_GLFW_ERR,
 	RV_GLAD_ERR,
-	RV_EXIT_ERR
+	RV_EXIT_ERR,
+	RV_ALLOC_ERR,
+	RV_WRITE_ERR,
+	RV_SIZE_ERR,
+	RV_LIVE_ERR,
+	RV_STOPPED
 };
 
 void print_rule(uint8_t r);
 void print_rule_variants(struct Options* options);
-void save_image(struct Options* options);
 
 int main(int argc, char* argv[]) {
 	/* argument parsing and function selection ***************************/
 	struct Options options = {0};
-	enum ParseStatus ps = parse_args(&options, argc, argv);
+	struct Selection selection;
+	enum ParseStatus ps = parse_args(&options, &selection, argc, argv);
 
 	if (ps == PARSE_HELP) {
-		fprintf(stderr, help_text);
+		for (const char** section = help_text; *section; ++section) {
+			fputs(*section, stderr);
+		}
 		return RV_OK;
 	}
 
@@ -42,23 +55,163 @@ int main(int argc, char* argv[]) {
 		return RV_BAD_ARGS;
 	}
 
+	if (options.stats && !stats_enable()) {
+		fprintf(stderr, "error: could not register exit function\n");
+		return RV_EXIT_ERR;
+	}
+
 	if (options.mode == MODE_LIST_RULES) {
 		print_rule_variants(&options);
 
 		return RV_OK;
 	}
 
-	/* standard display draws black pixels on a white background */
-	if (options.mode == MODE_STANDARD) {
-		pixel_off  = 0xff - pixel_off;
-		pixel_half = 0xff - pixel_half;
-		pixel_on   = 0xff - pixel_on;
+	/* batches *********************************************************/
+	if (options.batch_file != NULL) {
+		return batch_run_file(options.batch_file, options.threads)
+			? RV_OK : RV_WRITE_ERR;
+	}
+
+	size_t job_count = options_expand(&options, &selection, NULL);
+	if (job_count > 1 && options.output_file != NULL) {
+		fprintf(stderr, "error: -o names one image, not a batch\n");
+		return RV_BAD_ARGS;
+	}
+
+	if (job_count > 1 && options.live > 0) {
+		fprintf(stderr, "error: -l shows one image, not a batch\n");
+		return RV_BAD_ARGS;
+	}
+
+	if (job_count > 1 && options.initial_file != NULL) {
+		fprintf(stderr, "error: -I starts one run, not a batch\n");
+		return RV_BAD_ARGS;
+	}
+
+	if (job_count > 1 && options.output == OUTPUT_RNG) {
+		fprintf(stderr, "error: -f rng writes one stream, not a batch\n");
+		return RV_BAD_ARGS;
+	}
+
+	if (job_count > 1
+	 && (options.checkpoint_file != NULL || options.resume_file != NULL)) {
+		fprintf(stderr, "error: -c and -R carry on one run, not a batch\n");
+		return RV_BAD_ARGS;
+	}
+
+	if (job_count > 1) {
+		struct Options* jobs = malloc(job_count * sizeof(*jobs));
+		if (jobs == NULL) {
+			fprintf(stderr, "error: could not allocate jobs\n");
+			return RV_ALLOC_ERR;
+		}
+
+		options_expand(&options, &selection, jobs);
+		bool ok = batch_run(jobs, job_count, options.threads);
+		free(jobs);
+
+		return ok ? RV_OK : RV_WRITE_ERR;
+	}
+
+	/* checkpoints *******************************************************/
+	/* a resumed run is the run it was saved from, seeked to `-s` */
+	if (options.resume_file != NULL) {
+		struct Checkpoint checkpoint;
+		if (!checkpoint_open(&checkpoint, options.resume_file)) {
+			return RV_BAD_ARGS;
+		}
+
+		uint64_t generation = checkpoint.header->generation;
+		checkpoint_apply(&checkpoint, &options);
+		checkpoint_close(&checkpoint);
+
+		if (options.start == 0) {
+			options.start = generation;
+		}
+		if (options.start < generation) {
+			fprintf(
+				stderr, "error: %s starts at generation %llu\n",
+				options.resume_file, (unsigned long long)generation
+			);
+			return RV_BAD_ARGS;
+		}
+	}
+
+	/* a PBM sets the width of the run */
+	if (options.initial_file != NULL
+	 && !initial_file_width(options.initial_file, &options.width)) {
+		return RV_BAD_ARGS;
+	}
+
+	if (options.checkpoint_file != NULL && !checkpoint_catch_signals()) {
+		fprintf(stderr, "error: could not catch signals\n");
+		return RV_EXIT_ERR;
+	}
+
+	/* rendering *********************************************************/
+	/*
+	 * rows are streamed to the image as they are generated, the whole image
+	 * is only kept when it is to be displayed, which is never for the
+	 * uncompressed formats as they are meant to be streamed
+	 */
+	if (options.output != OUTPUT_PNG && options.live == 0) {
+		options.headless = true;
+	}
+
+	/* the live view is generated as it is shown, and nothing is saved */
+	uint8_t* display_buffer = NULL;
+	if (!options.headless && options.live == 0) {
+		size_t row_size = options.width * channel_count;
+		display_buffer = malloc(row_size * options.height);
+		if (display_buffer == NULL) {
+			fprintf(stderr, "error: could not allocate display buffer\n");
+			return RV_ALLOC_ERR;
+		}
+		stats_count(STATS_DISPLAY_BUFFER, row_size * options.height);
+	}
+
+	char* filename = make_filename(&options);
+	const char* output_file = (options.output_file != NULL)
+		? options.output_file : filename;
+
+	if (options.live == 0
+	 && !render_file(&options, output_file, display_buffer)) {
+		/* a run stopped by a signal has already said where it was saved */
+		bool stopped = checkpoint_stopped();
+		if (!stopped) {
+			fprintf(stderr, "error: could not write %s\n", output_file);
+		}
+		free(filename);
+		free(display_buffer);
+		return stopped ? RV_STOPPED : RV_WRITE_ERR;
 	}
 
+	free(filename);
+
+	if (options.headless) {
+		return RV_OK;
+	}
+
+
+	/* keep the aspect ratio of the canvas if it is scaled down */
+	double scale = 1.0;
+	if (options.width > max_window_width) {
+		scale = (double)max_window_width / options.width;
+	}
+	if (options.height * scale > max_window_height) {
+		scale = (double)max_window_height / options.height;
+	}
+
+	int window_width = options.width * scale;
+	int window_height = options.height * scale;
+	if (window_width < 1)  { window_width = 1; }
+	if (window_height < 1) { window_height = 1; }
+
 	/* initialise opengl and create window *******************************/
+	uint64_t window_begin = stats_clock();
 	glfwInit();
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
 	GLFWwindow* window = glfwCreateWindow(
@@ -85,6 +238,18 @@ int main(int argc, char* argv[]) {
 		fprintf(stderr, "error: gladLoadGL\n");
 		return RV_GLAD_ERR;
 	}
+	stats_end(STATS_WINDOW, window_begin);
+
+	GLint max_texture_size = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+	if (options.width > (size_t)max_texture_size
+	 || options.height > (size_t)max_texture_size) {
+		fprintf(
+			stderr, "error: canvas larger than %ix%i, use -n to save it\n",
+			max_texture_size, max_texture_size
+		);
+		return RV_SIZE_ERR;
+	}
 
 	/* shader program ****************************************************/
 	GLuint vshader_id = glCreateShader(GL_VERTEX_SHADER);
@@ -93,8 +258,9 @@ int main(int argc, char* argv[]) {
 		"layout (location = 0) in vec2 a_position;\n"
 		"out vec2 f_tex_coords;\n"
 		"uniform mat4 matrix;\n"
+		"uniform float offset;\n"
 		"void main () {\n"
-		"	f_tex_coords = a_position;\n"
+		"	f_tex_coords = a_position + vec2(0.0, offset);\n"
 		"	gl_Position = matrix * vec4(a_position, 0.0, 1.0);\n"
 		"}\n";
 	glShaderSource(vshader_id, 1, &vshader_string, NULL);
@@ -167,73 +333,51 @@ int main(int argc, char* argv[]) {
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
-	/* display buffer ****************************************************/
-	size_t row_size = window_width * channel_count;
-	size_t buffer_size = row_size * window_height;
-	uint8_t* display_buffer = malloc(buffer_size);
-	memset(display_buffer, pixel_off, buffer_size);
-
-	/* set initial generation */
-	eca_init_fn* init_fn = NULL;
-	switch (options.initial) {
-		default:
-		case INIT_STANDARD:  init_fn = eca_initialise;           break;
-		case INIT_ALTERNATE: init_fn = eca_initialise_alternate; break;
-		case INIT_RANDOM:    init_fn = eca_initialise_random;    break;
-	}
-
-	init_fn(display_buffer, window_width, channel_count);
-
-	/* generation all */
-	eca_gen_fn* gen_fn = NULL;
-	switch (options.mode) {
-		default:
-		case MODE_STANDARD:    gen_fn = eca_generate;             break;
-		case MODE_SPLIT:       gen_fn = eca_generate_split;       break;
-		case MODE_DIRECTIONAL: gen_fn = eca_generate_directional; break;
-	}
-
-	for (size_t i = 0; i < window_height - 1; ++i) {
-		uint8_t* current = display_buffer + ((row_size) * i);
-		uint8_t* next = current + (row_size);
-		gen_fn(next, current, window_width, 3, options.rules);
-	}
-
-	/* display texture ***************************************************/
-	GLuint display_texture;
-	glGenTextures(1, &display_texture);
-	glBindTexture(GL_TEXTURE_2D, display_texture);
+	/* live view *********************************************************/
+	GLuint display_texture = 0;
+	bool shown = true;
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(
-		GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST
-	);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-	glTexImage2D(
-		GL_TEXTURE_2D, 0, GL_RGB,
-		window_width, window_height,
-		0, GL_RGB, GL_UNSIGNED_BYTE, display_buffer
-	);
-	glGenerateMipmap(GL_TEXTURE_2D);
+	if (options.live > 0) {
+		shown = live_run(&options, window, program_id, vao);
+	} else {
+		/* display texture ***********************************************/
+		glGenTextures(1, &display_texture);
+		glBindTexture(GL_TEXTURE_2D, display_texture);
 
-	/* main loop *********************************************************/
-	int x = 1;
-	while(!glfwWindowShouldClose(window)) {
-		glfwPollEvents();
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(
+			GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST
+		);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+		/* rows are tightly packed, whatever the width */
+		uint64_t upload_begin = stats_clock();
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage2D(
+			GL_TEXTURE_2D, 0, GL_RGB,
+			options.width, options.height,
+			0, GL_RGB, GL_UNSIGNED_BYTE, display_buffer
+		);
+		glGenerateMipmap(GL_TEXTURE_2D);
+
+		/* the upload is only known to be done once the driver has finished */
+		if (stats_enabled()) {
+			glFinish();
+			stats_end(STATS_UPLOAD, upload_begin);
+		}
 
-		glClear(GL_COLOR_BUFFER_BIT);
-		glUseProgram(program_id);
-		glBindTexture(GL_TEXTURE_2D, display_texture);
-		glBindVertexArray(vao);
-		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_BYTE, NULL);
+		/* main loop *****************************************************/
+		while(!glfwWindowShouldClose(window)) {
+			glfwPollEvents();
 
-		glfwSwapBuffers(window);
+			glClear(GL_COLOR_BUFFER_BIT);
+			glUseProgram(program_id);
+			glBindTexture(GL_TEXTURE_2D, display_texture);
+			glBindVertexArray(vao);
+			glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_BYTE, NULL);
 
-		if (x != 0) {
-			x = 0;
-			save_image(&options);
+			glfwSwapBuffers(window);
 		}
 	}
 
@@ -248,7 +392,7 @@ int main(int argc, char* argv[]) {
 	glfwDestroyWindow(window);
 	glfwTerminate();
 
-	return RV_OK;
+	return shown ? RV_OK : RV_LIVE_ERR;
 }
 
 void print_rule(uint8_t r) {
@@ -302,71 +446,3 @@ char* byte_to_str(uint8_t n) {
 
 	return s;
 }
-
-char* make_filename(struct Options* options) {
-	char* name_buffer = malloc(128);
-	char* p = name_buffer;
-
-	memcpy(p, "rule", 4);
-	p += 4;
-
-	int rule_count = 1;
-	if (options->mode == MODE_SPLIT) { rule_count = channel_count; }
-	for (int i = 0; i < rule_count; ++i) {
-		uint8_t n = options->rules[i];
-		char* str = malloc(4);
-
-		str[0] = '0' +  n / 100;
-		str[1] = '0' + (n /  10) % 10;
-		str[2] = '0' +  n        % 10;
-
-		*p++ = '-';
-		memcpy(p, str, 3);
-		p += 3;
-
-		free(str);
-	}
-
-	if (options->mode != MODE_STANDARD) {
-		const char* mode_string = modestr(options->mode);
-		size_t mode_string_sz = strlen(mode_string);
-
-		*p++ = '-';
-		memcpy(p, mode_string, mode_string_sz);
-		p += mode_string_sz;
-	}
-
-	if (options->initial != INIT_STANDARD) {
-		const char* init_string = initstr(options->initial);
-		size_t init_string_sz = strlen(init_string);
-
-		*p++ = '-';
-		memcpy(p, init_string, init_string_sz);
-		p += init_string_sz;
-	}
-
-	memcpy(p, ".png", 5);
-	return name_buffer;
-}
-
-void save_image(struct Options* options) {
-	size_t row_size = window_width * channel_count;
-	size_t buffer_size = row_size * window_height;
-
-	uint8_t* pixels = malloc(buffer_size);
-	char* filename = make_filename(options);
-
-	glReadBuffer(GL_FRONT);
-	glReadPixels(
-		0, 0, window_width, window_height,
-		GL_RGB, GL_UNSIGNED_BYTE, pixels
-	);
-	stbi_flip_vertically_on_write(1);
-	stbi_write_png(
-		filename, window_width, window_height, channel_count,
-		pixels, row_size
-	);
-
-	free(filename);
-	free(pixels);
-}
@@ -1,5 +1,10 @@
 #include "options.h"
 
+#include "pool.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -21,12 +26,59 @@ static const char* initstrings[] = {
 	"random"
 };
 
-const char* help_text = (
+static const char* enginestrings[] = {
+	"unknown",
+	"packed",
+	"byte",
+	"lut",
+	"tiled",
+	"hashlife"
+};
+
+static const char* outputstrings[] = {
+	"unknown",
+	"png",
+	"pbm",
+	"ppm",
+	"csv",
+	"bin",
+	"rng"
+};
+
+/* options without a short form are numbered after the characters */
+enum LongOption {
+	OPTION_STATS = 256,
+	OPTION_COLUMNS,
+	OPTION_SEED,
+	OPTION_DENSITY
+};
+
+static const struct option long_options[] = {
+	{"stats", no_argument, NULL, OPTION_STATS},
+	{"columns", required_argument, NULL, OPTION_COLUMNS},
+	{"seed", required_argument, NULL, OPTION_SEED},
+	{"density", required_argument, NULL, OPTION_DENSITY},
+	{NULL, 0, NULL, 0}
+};
+
+/* split into sections, C99 only promises string literals of 4095 bytes */
+const char* help_text[] = {
 "Usage: wolfram -h\n"
 "Usage: wolfram -v -r RULE\n"
-"Usage: wolfram [-i INITIAL] [-m standard]   -r RULE\n"
-"Usage: wolfram [-i INITIAL]  -m directional -r RULE\n"
-"Usage: wolfram [-i INITIAL]  -m split       -r RULE -g RULE -b RULE\n"
+"Usage: wolfram -i random [--seed SEED] [--density DENSITY] ...\n"
+"Usage: wolfram -I FILE ...\n"
+"Usage: wolfram [-W WIDTH] [-H HEIGHT] [-i INITIAL] [-m standard]   -r RULE\n"
+"Usage: wolfram [-W WIDTH] [-H HEIGHT] [-i INITIAL]  -m directional -r RULE\n"
+"Usage: wolfram [-W WIDTH] [-H HEIGHT] [-i INITIAL]  -m split       -r RULE\n"
+"                                                    -g RULE -b RULE\n"
+"Usage: wolfram -e hashlife [-s START] [-M MIB] ...\n"
+"Usage: wolfram -f pbm|ppm|csv|bin [-o FILE] ...\n"
+"Usage: wolfram -f rng [--columns COUNT] [-o FILE] ...\n"
+"Usage: wolfram -l ROWS ...\n"
+"Usage: wolfram [-c FILE [-C GENERATIONS]] [-R FILE] ...\n"
+"Usage: wolfram [-j THREADS] -B FILE\n"
+"Usage: wolfram --stats ...\n",
+
 "\n"
 "Generates an elementary cellular automata.\n"
 "\n"
@@ -35,24 +87,121 @@ const char* help_text = (
 "                          channels. Ignored if MODE (-m) is not 'split'.\n"
 "  -i INITIAL            Initial population {standard, alternate, random}\n"
 "                          Default: standard\n"
+"  -I FILE               Read the initial population from FILE, a binary\n"
+"                          PBM or a bitfile of packed cells.\n"
+"  --seed SEED           Seed for a random initial population, which is\n"
+"                          then made by a counter-based generator.\n"
+"  --density DENSITY     Chance of each random cell being activated (0-1).\n"
+"                          Default: 0.5\n"
 "  -m MODE               Generation mode {standard, split, directional}\n"
 "                          Default: standard\n"
 "                          If 'split' is chosen for the mode, both of '-g'\n"
 "                          and '-b' must also be specified.\n"
+"  -e ENGINE             Generation engine\n"
+"                          {packed, byte, lut, tiled, hashlife}\n"
+"                          Default: packed\n"
+"  -W WIDTH              Cells per generation, Default: 640\n"
+"  -H HEIGHT             Generations, Default: 480\n"
+"                          Large canvases are best saved with '-n', rows are\n"
+"                          then written out as they are generated. PNGs and\n"
+"                          the window hold at most 2147483647 of either.\n"
+"  -k STRIDE             Show every STRIDE-th generation, Default: 1\n"
+"  -s START              Generation shown first, Default: 0\n"
+"  -M MIB                Memory for the hashlife engine's tables in MiB.\n"
+"                          Default: 256\n"
+"  -f FORMAT             Image format {png, pbm, ppm, csv, bin, rng}\n"
+"                          Default: png\n"
+"                          PBM and PPM images are streamed uncompressed,\n"
+"                          without opening a window. CSV and bin write the\n"
+"                          statistics of each generation instead, and rng\n"
+"                          writes random bits from columns of the rule.\n"
+"  -o FILE               Save the image as FILE, or write it to stdout if\n"
+"                          FILE is '-'. Default: named after the options\n"
+"  -z LEVEL              PNG compression level (0-9), Default: 6\n"
+"  -j THREADS            Threads for the packed and tiled engines and the\n"
+"                          PNG encoder, or for batches of jobs.\n"
+"                          Default: one per processor\n"
+"  -B FILE               Read jobs from FILE, one set of options per line.\n"
+"  -l ROWS               Keep generating while the window is open, scrolling\n"
+"                          ROWS new generations up each frame. Nothing is\n"
+"                          saved. Default: 0, show a still image\n"
+"  -c FILE               Save a checkpoint of the packed engine to FILE when\n"
+"                          the run ends, or is stopped by SIGINT or SIGTERM,\n"
+"                          and when sent SIGUSR1.\n"
+"  -C GENERATIONS        Also save a checkpoint every GENERATIONS.\n"
+"                          Default: 0, only when the run ends\n"
+"  -R FILE               Resume the run of the checkpoint FILE, with its\n"
+"                          rules, mode, and width. '-s' may start later.\n"
+"  -n                    Save the image without opening a window, and exit.\n"
 "  -v                    Display rule variants (mirror, inverse) and exit.\n"
 "  -h                    Display this text and exit.\n"
+"  --stats               Report the time spent in each phase, the cells\n"
+"                          generated, bytes written, and peak memory as\n"
+"                          JSON on stderr when the program exits.\n"
+"  --columns COUNT       Columns read for random bits (-f rng), spaced\n"
+"                          evenly from the centre. Default: 1\n",
+
+"\n"
+"Batches:\n"
+"  RULE, INITIAL, and MODE may be comma separated lists, and RULE may also\n"
+"  be a range such as 0-255. Each combination is saved as a separate image,\n"
+"  without opening a window, as are the jobs of a FILE (-B).\n",
+
+"\n"
+"Statistics (-f csv, -f bin):\n"
+"  One record per generation: the generation, activated cells (and their\n"
+"  density in CSV), runs of activated cells, the centre cell, and the\n"
+"  entropy of blocks of 8 cells in bits per cell. Only the first plane of\n"
+"  split and directional modes is measured. Binary records are four 64 bit\n"
+"  integers and a double, in the byte order of the machine.\n",
+
+"\n"
+"Random bits (-f rng):\n"
+"  64 lanes of WIDTH cells are run side by side, bit-sliced into words, each\n"
+"  from its own random row. Each generation from START, every STRIDE-th,\n"
+"  writes one 64 bit word per column with a bit from each lane, in the byte\n"
+"  order of the machine. Only standard mode is supported, and '-i' is not.\n"
+"  HEIGHT sets the number of generations written.\n",
+
+"\n"
+"Checkpoints (-c, -R):\n"
+"  A checkpoint holds the last generation of a run, packed 64 cells to a\n"
+"  word, with the generation it was taken at and the options needed to carry\n"
+"  on. Resuming maps the file, so the run picks up at once, and '-s' seeks\n"
+"  forward from the checkpoint to the first generation shown.\n",
+
 "\n"
 "Initial Population (-i):\n"
 "  standard              Only the centre cell is activated.\n"
 "  alternate             Every other cell is activated.\n"
-"  random                Cell activation is random.\n"
+"  random                Cell activation is random. The same row is made\n"
+"                          each time, unless given a seed or density.\n"
+"\n"
+"Initial Files (-I):\n"
+"  A binary PBM sets the width, and its first row is used. Any other file is\n"
+"  read as a bitfile of WIDTH cells, cell i in bit (i % 8) of byte (i / 8).\n"
 "\n"
 "Generation Modes (-m):\n"
 "  standard              A standard black/white generation.\n"
 "  split                 Red, green, and blue channels are split.\n"
 "  directional           The colour of each cell depends on which parents\n"
 "                          were responsible for its activation.\n"
-);
+"\n"
+"Generation Engines (-e):\n"
+"  packed                Cells are stored as bits, 64 to a word, and only\n"
+"                          expanded into pixels for display.\n"
+"  byte                  Cells are stored and generated as pixels.\n"
+"  lut                   Cells are stored as pixels, and generated eight at\n"
+"                          a time from a table built for each rule.\n"
+"  tiled                 As packed, but tiles of each row are advanced up to\n"
+"                          64 generations at a time while they are in cache.\n"
+"  hashlife              Blocks of cells are stored once and the result of\n"
+"                          advancing each is remembered, so that regular\n"
+"                          patterns jump to late generations (-s, -k) in\n"
+"                          logarithmic time. Hits and misses are reported.\n",
+
+NULL
+};
 
 const char* modestr(enum Mode mode) {
 	if (mode >= MODE_LAST) {
@@ -70,6 +219,22 @@ const char* initstr(enum Initial init) {
 	return initstrings[init];
 }
 
+const char* enginestr(enum Engine engine) {
+	if (engine >= ENGINE_LAST) {
+		engine = ENGINE_UNKNOWN;
+	}
+
+	return enginestrings[engine];
+}
+
+const char* outputstr(enum Output output) {
+	if (output >= OUTPUT_LAST) {
+		output = OUTPUT_UNKNOWN;
+	}
+
+	return outputstrings[output];
+}
+
 bool compare(const char* a, const char* b) {
 	size_t sz_a = strlen(a);
 	size_t sz_b = strlen(b);
@@ -101,6 +266,37 @@ enum Initial parse_initial(const char* src) {
 	return INIT_UNKNOWN;
 }
 
+enum Engine parse_engine(const char* src) {
+	for (enum Engine e = ENGINE_UNKNOWN; e < ENGINE_LAST; ++e) {
+		if (compare(src, enginestrings[e])) {
+			return e;
+		}
+	}
+
+	return ENGINE_UNKNOWN;
+}
+
+enum Output parse_output(const char* src) {
+	for (enum Output o = OUTPUT_UNKNOWN; o < OUTPUT_LAST; ++o) {
+		if (compare(src, outputstrings[o])) {
+			return o;
+		}
+	}
+
+	return OUTPUT_UNKNOWN;
+}
+
+double parse_real(const char* src) {
+	char* endptr = NULL;
+	double num = strtod(src, &endptr);
+
+	if (src == endptr || *endptr != 0) {
+		return -1.0;
+	}
+
+	return num;
+}
+
 long parse_num(const char* src) {
 	const char* strend = src + strlen(src);
 	char* endptr = NULL;
@@ -116,49 +312,259 @@ long parse_num(const char* src) {
 	return num;
 }
 
-enum ParseStatus parse_args(struct Options* options, int argc, char* argv[]) {
+/* the whole range of a uint64_t, which does not fit the long of parse_num */
+static bool parse_u64(const char* src, uint64_t* num) {
+	char* endptr = NULL;
+	errno = 0;
+	unsigned long long value = strtoull(src, &endptr, 10);
+
+	/* strtoull would also take leading spaces and negate a leading '-' */
+	if (!isdigit((unsigned char)*src) || *endptr != '\0' || errno != 0) {
+		return false;
+	}
+
+	*num = value;
+	return true;
+}
+
+/* called for each item of a comma separated list */
+typedef bool item_fn(char* item, void* context);
+
+static bool parse_list(const char* src, item_fn* fn, void* context) {
+	char item[32];
+
+	for (;;) {
+		size_t size = strcspn(src, ",");
+		if (size == 0 || size >= sizeof(item)) {
+			return false;
+		}
+
+		memcpy(item, src, size);
+		item[size] = 0;
+		if (!fn(item, context)) {
+			return false;
+		}
+
+		if (src[size] == 0) {
+			return true;
+		}
+		src += size + 1;
+	}
+}
+
+static bool parse_mode_item(char* item, void* context) {
+	bool* modes = context;
+	enum Mode mode = parse_mode(item);
+	modes[mode] = true;
+
+	return mode != MODE_UNKNOWN;
+}
+
+static bool parse_initial_item(char* item, void* context) {
+	bool* initials = context;
+	enum Initial init = parse_initial(item);
+	initials[init] = true;
+
+	return init != INIT_UNKNOWN;
+}
+
+/* a single rule, or an inclusive range of rules such as `0-255` */
+static bool parse_rule_item(char* item, void* context) {
+	bool* rules = context;
+
+	char* dash = strchr(item, '-');
+	if (dash != NULL) {
+		*dash = 0;
+	}
+
+	long first = parse_num(item);
+	long last = (dash != NULL) ? parse_num(dash + 1) : first;
+
+	if (first < 0 || last > 255 || first > last) {
+		return false;
+	}
+
+	for (long rule = first; rule <= last; ++rule) {
+		rules[rule] = true;
+	}
+
+	return true;
+}
+
+static int first_set(const bool* set, int count) {
+	for (int i = 0; i < count; ++i) {
+		if (set[i]) {
+			return i;
+		}
+	}
+
+	return 0;
+}
+
+enum ParseStatus parse_args(
+	struct Options* options, struct Selection* selection,
+	int argc, char* argv[]
+) {
 	/* todo: mutually exclusive options? no -m and -v? */
 	enum ParseStatus rv = PARSE_OK;
 
-	bool r_set = false;
-	bool g_set = false;
-	bool b_set = false;
+	bool list_rules = false;
+	bool m_set = false;
+	bool i_set = false;
+	bool rules_set[3] = {false, false, false};
+	bool rules_valid[3] = {true, true, true};
+	bool modes_valid = true;
+	bool initials_valid = true;
 
-	long r_value = 0;
-	long g_value = 0;
-	long b_value = 0;
+	long w_value = 640;
+	long h_value = 480;
+	long j_value = pool_processor_count();
+	uint64_t k_value = 1;
+	bool k_ok = true;
+	uint64_t s_value = 0;
+	bool s_ok = true;
+	long M_value = 256;
+	long z_value = 6;
+	long l_value = 0;
+	long C_value = 0;
+	long columns_value = 1;
+	uint64_t seed_value = 0;
+	bool seed_ok = true;
+	double density_value = 0.5;
+	bool seeded = false;
+	const char* I_value = NULL;
 
-	options->mode = MODE_STANDARD;
-	options->initial = INIT_STANDARD;
+	memset(selection, 0, sizeof(*selection));
+	options->engine = ENGINE_PACKED;
+	options->headless = false;
+	options->batch_file = NULL;
+	options->output = OUTPUT_PNG;
+	options->output_file = NULL;
+	options->checkpoint_file = NULL;
+	options->resume_file = NULL;
+	options->stats = false;
+
+	/* restart scanning, the job files are parsed line by line */
+	optind = 0;
 
 	int c = -1;
-	while ((c = getopt(argc, argv, "hvi:m:r:g:b:")) != -1) {
+	const char* short_options = "hnve:i:I:m:r:g:b:W:H:j:k:s:M:B:z:f:o:l:c:C:R:";
+	while ((c = getopt_long(
+		argc, argv, short_options, long_options, NULL
+	)) != -1) {
 		switch (c) {
 			case 'm': {
-				options->mode = parse_mode(optarg);
+				m_set = true;
+				modes_valid = parse_list(
+					optarg, parse_mode_item, selection->modes
+				);
+				break;
+			}
+			case 'n': {
+				options->headless = true;
 				break;
 			}
 			case 'v': {
-				options->mode = MODE_LIST_RULES;
+				list_rules = true;
 				break;
 			}
-			case 'r': {
-				r_set = true;
-				r_value = parse_num(optarg);
+			case 'r':
+			case 'g':
+			case 'b': {
+				int n = (c == 'r') ? 0 : (c == 'g') ? 1 : 2;
+				rules_set[n] = true;
+				rules_valid[n] = parse_list(
+					optarg, parse_rule_item, selection->rules[n]
+				);
 				break;
 			}
-			case 'g': {
-				g_set = true;
-				g_value = parse_num(optarg);
+			case 'i': {
+				i_set = true;
+				initials_valid = parse_list(
+					optarg, parse_initial_item, selection->initials
+				);
 				break;
 			}
-			case 'b': {
-				b_set = true;
-				b_value = parse_num(optarg);
+			case 'e': {
+				options->engine = parse_engine(optarg);
 				break;
 			}
-			case 'i': {
-				options->initial = parse_initial(optarg);
+			case 'W': {
+				w_value = parse_num(optarg);
+				break;
+			}
+			case 'H': {
+				h_value = parse_num(optarg);
+				break;
+			}
+			case 'j': {
+				j_value = parse_num(optarg);
+				break;
+			}
+			case 'k': {
+				k_ok = parse_u64(optarg, &k_value);
+				break;
+			}
+			case 's': {
+				s_ok = parse_u64(optarg, &s_value);
+				break;
+			}
+			case 'M': {
+				M_value = parse_num(optarg);
+				break;
+			}
+			case 'B': {
+				options->batch_file = optarg;
+				break;
+			}
+			case 'z': {
+				z_value = parse_num(optarg);
+				break;
+			}
+			case 'f': {
+				options->output = parse_output(optarg);
+				break;
+			}
+			case 'o': {
+				options->output_file = optarg;
+				break;
+			}
+			case 'l': {
+				l_value = parse_num(optarg);
+				break;
+			}
+			case 'c': {
+				options->checkpoint_file = optarg;
+				break;
+			}
+			case 'C': {
+				C_value = parse_num(optarg);
+				break;
+			}
+			case 'R': {
+				options->resume_file = optarg;
+				break;
+			}
+			case OPTION_STATS: {
+				options->stats = true;
+				break;
+			}
+			case OPTION_COLUMNS: {
+				columns_value = parse_num(optarg);
+				break;
+			}
+			case OPTION_SEED: {
+				seed_ok = parse_u64(optarg, &seed_value);
+				seeded = true;
+				break;
+			}
+			case OPTION_DENSITY: {
+				density_value = parse_real(optarg);
+				seeded = true;
+				break;
+			}
+			case 'I': {
+				I_value = optarg;
 				break;
 			}
 			case 'h': rv = PARSE_HELP; goto abort;
@@ -167,58 +573,363 @@ enum ParseStatus parse_args(struct Options* options, int argc, char* argv[]) {
 		}
 	}
 
-	if (options->mode == MODE_UNKNOWN) {
+	if (!m_set) {
+		selection->modes[MODE_STANDARD] = true;
+	}
+	if (!i_set) {
+		selection->initials[INIT_STANDARD] = true;
+	}
+
+	if (!modes_valid || selection->modes[MODE_LIST_RULES]) {
 		printf("%s: invalid argument for option -- 'm'\n", argv[0]);
 		printf("    choice {standard, split, directional}\n");
 		rv = PARSE_BAD_ARG;
 		goto abort;
 	}
+	options->mode = first_set(selection->modes, MODE_LAST);
 
-	if (options->initial == INIT_UNKNOWN) {
+	if (!initials_valid) {
 		printf("%s: invalid argument for option -- 'i'\n", argv[0]);
 		printf("    choice {standard, alternate, random}\n");
 		rv = PARSE_BAD_ARG;
 		goto abort;
 	}
+	options->initial = first_set(selection->initials, INIT_LAST);
+
+	if (options->engine == ENGINE_UNKNOWN) {
+		printf("%s: invalid argument for option -- 'e'\n", argv[0]);
+		printf("    choice {packed, byte, lut, tiled, hashlife}\n");
+		rv = PARSE_BAD_ARG;
+		goto abort;
+	}
+
+	if (options->output == OUTPUT_UNKNOWN) {
+		printf("%s: invalid argument for option -- 'f'\n", argv[0]);
+		printf("    choice {png, pbm, ppm, csv, bin, rng}\n");
+		rv = PARSE_BAD_ARG;
+		goto abort;
+	}
+
+	/* limited by the png format and the window, the other outputs stream */
+	bool shown = options->output == OUTPUT_PNG || l_value > 0;
+	long max_size = shown ? INT32_MAX : LONG_MAX;
+	if (w_value < 1 || w_value > max_size) {
+		printf("%s: width out of range -- 'W'\n", argv[0]);
+		rv = PARSE_BAD_ARG;
+		goto abort;
+	}
+	options->width = w_value;
+
+	if (h_value < 1 || h_value > max_size) {
+		printf("%s: height out of range -- 'H'\n", argv[0]);
+		rv = PARSE_BAD_ARG;
+		goto abort;
+	}
+	options->height = h_value;
 
-	if (!r_set) {
-		printf("%s: missing option -- 'r'\n", argv[0]);
+	if (!k_ok || k_value < 1 || k_value > SIZE_MAX) {
+		printf("%s: stride out of range -- 'k'\n", argv[0]);
+		rv = PARSE_BAD_ARG;
+		goto abort;
+	}
+	options->stride = k_value;
+
+	if (!s_ok) {
+		printf("%s: start out of range -- 's'\n", argv[0]);
+		rv = PARSE_BAD_ARG;
+		goto abort;
+	}
+	options->start = s_value;
+
+	/* the live view picks its own height to fit the last generation */
+	uint64_t span = (uint64_t)(h_value - 1);
+	if (span > (UINT64_MAX - s_value) / k_value && l_value == 0) {
+		printf("%s: last generation out of range -- 'H'\n", argv[0]);
+		rv = PARSE_BAD_ARG;
+		goto abort;
+	}
+
+	if (M_value < 1 || M_value > (long)(SIZE_MAX >> 20)) {
+		printf("%s: memory limit out of range -- 'M'\n", argv[0]);
+		rv = PARSE_BAD_ARG;
+		goto abort;
+	}
+	options->memory_limit = (size_t)M_value << 20;
+
+	if (z_value < 0 || z_value > 9) {
+		printf("%s: compression level out of range -- 'z'\n", argv[0]);
+		rv = PARSE_BAD_ARG;
+		goto abort;
+	}
+	options->compression = z_value;
+
+	if (j_value < 1 || j_value > 1024) {
+		printf("%s: thread count out of range -- 'j'\n", argv[0]);
+		rv = PARSE_BAD_ARG;
+		goto abort;
+	}
+	options->threads = j_value;
+
+	if (l_value < 0 || l_value > INT32_MAX) {
+		printf("%s: rows per frame out of range -- 'l'\n", argv[0]);
+		rv = PARSE_BAD_ARG;
+		goto abort;
+	}
+	options->live = l_value;
+
+	/* the live view is only ever shown, never saved */
+	if (options->live > 0 && options->headless) {
+		printf("%s: a live view needs a window -- 'l'\n", argv[0]);
+		rv = PARSE_BAD_ARG;
+		goto abort;
+	}
+
+	if (!seed_ok) {
+		printf("%s: seed out of range -- 'seed'\n", argv[0]);
+		rv = PARSE_BAD_ARG;
+		goto abort;
+	}
+	options->seed = seed_value;
+
+	if (!(density_value >= 0.0 && density_value <= 1.0)) {
+		printf("%s: density out of range -- 'density'\n", argv[0]);
+		rv = PARSE_BAD_ARG;
+		goto abort;
+	}
+	options->density = density_value;
+
+	/* only random rows are seeded */
+	options->seeded = seeded;
+	if (seeded && !selection->initials[INIT_RANDOM]) {
+		printf("%s: seeds and densities need -i random -- 'i'\n", argv[0]);
+		rv = PARSE_BAD_ARG;
+		goto abort;
+	}
+
+	/* a row from a file replaces the patterns of -i */
+	options->initial_file = I_value;
+	if (I_value != NULL && (i_set || options->resume_file != NULL)) {
+		printf("%s: an initial row file replaces -i and -R -- 'I'\n", argv[0]);
+		rv = PARSE_BAD_ARG;
+		goto abort;
+	}
+
+	if (C_value < 0) {
+		printf("%s: checkpoint interval out of range -- 'C'\n", argv[0]);
+		rv = PARSE_BAD_ARG;
+		goto abort;
+	}
+	options->checkpoint_interval = C_value;
+
+	if (C_value > 0 && options->checkpoint_file == NULL) {
+		printf("%s: missing option -- 'c'\n", argv[0]);
 		rv = PARSE_NO_ARG;
 		goto abort;
 	}
-	if (r_value < 0 || r_value > 255) {
-		printf("%s: rule out of range -- 'r'\n", argv[0]);
+
+	/* only the packed engine keeps a packed row to save or resume from */
+	bool checkpoints = options->checkpoint_file != NULL
+	                || options->resume_file != NULL;
+
+	if (checkpoints && options->engine != ENGINE_PACKED) {
+		printf("%s: checkpoints need the packed engine -- 'e'\n", argv[0]);
 		rv = PARSE_BAD_ARG;
 		goto abort;
 	}
-	options->rules[0] = r_value;
 
-	if (options->mode == MODE_SPLIT) {
-		if (!g_set) {
-			printf("%s: missing option -- 'g'\n", argv[0]);
-			rv = PARSE_NO_ARG;
+	if (checkpoints && options->live > 0) {
+		printf("%s: a live view is not checkpointed -- 'l'\n", argv[0]);
+		rv = PARSE_BAD_ARG;
+		goto abort;
+	}
+
+	if (columns_value < 1 || columns_value > w_value) {
+		printf("%s: column count out of range -- 'columns'\n", argv[0]);
+		rv = PARSE_BAD_ARG;
+		goto abort;
+	}
+	options->columns = columns_value;
+
+	/* random bits come from lanes of random rows of a single rule */
+	if (options->output == OUTPUT_RNG) {
+		bool standard = true;
+		for (enum Mode mode = MODE_SPLIT; mode < MODE_LAST; ++mode) {
+			standard = standard && !selection->modes[mode];
+		}
+
+		if (!standard) {
+			printf("%s: random bits need standard mode -- 'm'\n", argv[0]);
+			rv = PARSE_BAD_ARG;
 			goto abort;
 		}
-		if (g_value < 0 || g_value > 255) {
-			printf("%s: rule out of range -- 'g'\n", argv[0]);
+		if (i_set || I_value != NULL) {
+			printf("%s: random bits start from random rows -- 'i'\n", argv[0]);
 			rv = PARSE_BAD_ARG;
 			goto abort;
 		}
-		options->rules[1] = g_value;
+		if (checkpoints) {
+			printf("%s: random bits are not checkpointed -- 'c'\n", argv[0]);
+			rv = PARSE_BAD_ARG;
+			goto abort;
+		}
+	}
+
+	/* jobs come from the file instead */
+	if (options->batch_file != NULL) {
+		goto abort;
+	}
+
+	/*
+	 * the green and blue rules are only needed in split mode, and none are
+	 * needed to resume, as the checkpoint has them
+	 */
+	const char* rule_options = "rgb";
+	int rule_count = selection->modes[MODE_SPLIT] ? 3 : 1;
+	if (options->resume_file != NULL) {
+		rule_count = 0;
+	}
 
-		if (!b_set) {
-			printf("%s: missing option -- 'b'\n", argv[0]);
+	for (int n = 0; n < rule_count; ++n) {
+		if (!rules_set[n]) {
+			printf(
+				"%s: missing option -- '%c'\n", argv[0], rule_options[n]
+			);
 			rv = PARSE_NO_ARG;
 			goto abort;
 		}
-		if (b_value < 0 || b_value > 255) {
-			printf("%s: rule out of range -- 'b'\n", argv[0]);
+		if (!rules_valid[n]) {
+			printf(
+				"%s: rule out of range -- '%c'\n",
+				argv[0], rule_options[n]
+			);
 			rv = PARSE_BAD_ARG;
 			goto abort;
 		}
-		options->rules[2] = b_value;
+		options->rules[n] = first_set(selection->rules[n], 256);
+	}
+
+	if (list_rules) {
+		options->mode = MODE_LIST_RULES;
 	}
 
 abort:
 	return rv;
 }
+
+size_t options_expand(
+	const struct Options* options, const struct Selection* selection,
+	struct Options* jobs
+) {
+	/* the chosen rules of each channel, in order */
+	uint8_t rules[3][256];
+	size_t rule_counts[3] = {0, 0, 0};
+
+	for (int n = 0; n < 3; ++n) {
+		for (int rule = 0; rule < 256; ++rule) {
+			if (selection->rules[n][rule]) {
+				rules[n][rule_counts[n]++] = rule;
+			}
+		}
+	}
+
+	size_t count = 0;
+	for (enum Mode mode = MODE_STANDARD; mode < MODE_LIST_RULES; ++mode) {
+		if (!selection->modes[mode]) {
+			continue;
+		}
+
+		/* only split mode has green and blue rules */
+		bool split = mode == MODE_SPLIT;
+		size_t combinations = rule_counts[0];
+		if (split) {
+			combinations *= rule_counts[1] * rule_counts[2];
+		}
+
+		for (enum Initial init = INIT_STANDARD; init < INIT_LAST; ++init) {
+			if (!selection->initials[init]) {
+				continue;
+			}
+
+			for (size_t k = 0; jobs != NULL && k < combinations; ++k) {
+				struct Options* job = &jobs[count + k];
+				*job = *options;
+				job->mode = mode;
+				job->initial = init;
+				job->seeded = options->seeded && init == INIT_RANDOM;
+				job->rules[0] = rules[0][k % rule_counts[0]];
+				job->rules[1] = 0;
+				job->rules[2] = 0;
+
+				if (split) {
+					size_t gb = k / rule_counts[0];
+					job->rules[1] = rules[1][gb % rule_counts[1]];
+					job->rules[2] = rules[2][gb / rule_counts[1]];
+				}
+			}
+
+			count += combinations;
+		}
+	}
+
+	return count;
+}
+
+char* make_filename(const struct Options* options) {
+	char* name_buffer = malloc(128);
+	char* p = name_buffer;
+
+	memcpy(p, "rule", 4);
+	p += 4;
+
+	int rule_count = 1;
+	if (options->mode == MODE_SPLIT) { rule_count = 3; }
+	for (int i = 0; i < rule_count; ++i) {
+		uint8_t n = options->rules[i];
+		char* str = malloc(4);
+
+		str[0] = '0' +  n / 100;
+		str[1] = '0' + (n /  10) % 10;
+		str[2] = '0' +  n        % 10;
+
+		*p++ = '-';
+		memcpy(p, str, 3);
+		p += 3;
+
+		free(str);
+	}
+
+	if (options->mode != MODE_STANDARD) {
+		const char* mode_string = modestr(options->mode);
+		size_t mode_string_sz = strlen(mode_string);
+
+		*p++ = '-';
+		memcpy(p, mode_string, mode_string_sz);
+		p += mode_string_sz;
+	}
+
+	if (options->initial != INIT_STANDARD) {
+		const char* init_string = initstr(options->initial);
+		size_t init_string_sz = strlen(init_string);
+
+		*p++ = '-';
+		memcpy(p, init_string, init_string_sz);
+		p += init_string_sz;
+	}
+
+	/* seeded rows differ from the usual random row, and from each other */
+	if (options->seeded && options->initial == INIT_RANDOM) {
+		p += sprintf(p, "-seed-%llu", (unsigned long long)options->seed);
+		if (options->density != 0.5) {
+			p += sprintf(p, "-density-%g", options->density);
+		}
+	}
+
+	if (options->initial_file != NULL) {
+		memcpy(p, "-file", 5);
+		p += 5;
+	}
+
+	*p++ = '.';
+	memcpy(p, outputstr(options->output), 4);
+	return name_buffer;
+}
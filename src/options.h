@@ -2,9 +2,11 @@
 #define OPTIONS_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
-extern const char* help_text;
+/* the usage text, in sections ending with NULL */
+extern const char* help_text[];
 
 enum ParseStatus {
 	PARSE_OK      = 0,
@@ -31,14 +33,96 @@ enum Initial {
 	INIT_LAST      = 4
 };
 
+enum Engine {
+	ENGINE_UNKNOWN  = 0,
+	ENGINE_PACKED   = 1,
+	ENGINE_BYTE     = 2,
+	ENGINE_LUT      = 3,
+	ENGINE_TILED    = 4,
+	ENGINE_HASHLIFE = 5,
+	ENGINE_LAST     = 6
+};
+
+enum Output {
+	OUTPUT_UNKNOWN = 0,
+	OUTPUT_PNG     = 1,
+	OUTPUT_PBM     = 2,
+	OUTPUT_PPM     = 3,
+	OUTPUT_CSV     = 4,
+	OUTPUT_BINARY  = 5,
+	OUTPUT_RNG     = 6,
+	OUTPUT_LAST    = 7
+};
+
 struct Options {
 	enum Mode mode;
 	enum Initial initial;
+	bool seeded;              /* random rows from `seed` and `density` */
+	uint64_t seed;
+	double density;
+	const char* initial_file; /* NULL for the row of `initial` */
+	enum Engine engine;
+	enum Output output;
+	const char* output_file; /* NULL for the name of `make_filename` */
+	bool headless;
+	size_t live;             /* rows generated per frame, 0 for a still */
+	size_t columns;          /* columns read for random bits, see `rng.h` */
+	size_t width;
+	size_t height;
+	size_t stride;
+	uint64_t start;
+	size_t memory_limit;
+	int compression;
+	int threads;
+	const char* batch_file;
+	const char* checkpoint_file; /* NULL for no checkpoints */
+	uint64_t checkpoint_interval; /* generations, 0 for only at the end */
+	const char* resume_file;     /* NULL to start from generation 0 */
+	bool stats;
 	uint8_t rules[3];
 };
 
+/*
+ * Rules, initial generations, and modes may be given as comma separated
+ * lists, and rules also as ranges, eg. `-r 0-255 -i standard,random`. Every
+ * combination of them is rendered as a separate job.
+ */
+struct Selection {
+	bool rules[3][256];
+	bool initials[INIT_LAST];
+	bool modes[MODE_LAST];
+};
+
 const char* modestr(enum Mode mode);
 const char* initstr(enum Initial mode);
-enum ParseStatus parse_args(struct Options* options, int argc, char* argv[]);
+const char* enginestr(enum Engine engine);
+const char* outputstr(enum Output output);
+
+/**
+ * Parses a command line, `options` is set to the first job of `selection`.
+ */
+enum ParseStatus parse_args(
+	struct Options* options, struct Selection* selection,
+	int argc, char* argv[]
+);
+
+/**
+ * Writes a copy of `options` for every job of `selection` to `jobs`.
+ *
+ * - `jobs` may be NULL to only count them.
+ * - returns the number of jobs.
+ */
+size_t options_expand(
+	const struct Options* options, const struct Selection* selection,
+	struct Options* jobs
+);
+
+/**
+ * The name an image is saved under, eg. `rule-030-random.png`, with the
+ * extension of its output format.
+ *
+ * - the caller must free the returned string.
+ */
+char* make_filename(const struct Options* options);
 
 #endif /* OPTIONS_H */
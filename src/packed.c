@@ -0,0 +1,506 @@
+#include "packed.h"
+
+#include "eca.h"
+#include "rules.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+size_t eca_packed_words(size_t width) {
+	return (width + 63) / 64;
+}
+
+/* mask of the valid bits in the final word of a plane */
+static uint64_t last_word_mask(size_t width) {
+	unsigned int used = width % 64;
+	return (used == 0) ? ~(uint64_t)0 : ((uint64_t)1 << used) - 1;
+}
+
+static void copy_planes(uint64_t* dst, size_t width, int plane_count) {
+	size_t words = eca_packed_words(width);
+	for (int plane = 1; plane < plane_count; ++plane) {
+		memcpy(dst + (plane * words), dst, words * sizeof(*dst));
+	}
+}
+
+/* populates an initial generation */
+void eca_packed_initialise(uint64_t* dst, size_t width, int plane_count) {
+	size_t words = eca_packed_words(width);
+	memset(dst, 0, words * sizeof(*dst));
+
+	size_t centre = width / 2;
+	dst[centre / 64] |= (uint64_t)1 << (centre % 64);
+
+	copy_planes(dst, width, plane_count);
+}
+
+void eca_packed_initialise_alternate(
+	uint64_t* dst, size_t width, int plane_count
+) {
+	size_t words = eca_packed_words(width);
+	for (size_t i = 0; i < words; ++i) {
+		dst[i] = 0xaaaaaaaaaaaaaaaa; /* odd cells are activated */
+	}
+	dst[words - 1] &= last_word_mask(width);
+
+	copy_planes(dst, width, plane_count);
+}
+
+void eca_packed_initialise_random(
+	uint64_t* dst, size_t width, int plane_count
+) {
+	size_t words = eca_packed_words(width);
+	memset(dst, 0, words * sizeof(*dst));
+
+	struct EcaRandom random;
+	eca_random_seed(&random, 0);
+	for (size_t i = 0; i < width; ++i) {
+		uint64_t val = eca_random_next(&random) % 2;
+		dst[i / 64] |= val << (i % 64);
+	}
+
+	copy_planes(dst, width, plane_count);
+}
+
+/* word `counter` of the stream `seed`, SplitMix64 indexed directly */
+static uint64_t counter_random(uint64_t seed, uint64_t counter) {
+	uint64_t z = seed + ((counter + 1) * 0x9e3779b97f4a7c15);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+
+	return z ^ (z >> 31);
+}
+
+void eca_packed_initialise_seeded(
+	uint64_t* dst, size_t width, int plane_count,
+	uint64_t seed, double density, size_t begin, size_t end
+) {
+	/* the density to 16 bits, each bit halves the odds of the ones below */
+	uint32_t threshold = (uint32_t)((density * 65536.0) + 0.5);
+	int lowest = (threshold == 0) ? 16 : __builtin_ctz(threshold);
+
+	/* streams of different seeds start far apart */
+	uint64_t key = counter_random(seed, UINT64_MAX);
+
+	size_t words = eca_packed_words(width);
+	for (size_t i = begin; i < end; ++i) {
+		uint64_t cells = 0;
+		for (int bit = lowest; bit < 16; ++bit) {
+			uint64_t random = counter_random(key, (i * 16) + bit);
+			cells = ((threshold >> bit) & 1) ? (cells | random)
+			                                 : (cells & random);
+		}
+		if (threshold >= 65536) {
+			cells = ~(uint64_t)0;
+		}
+
+		dst[i] = cells;
+	}
+
+	if (end == words) {
+		dst[words - 1] &= last_word_mask(width);
+	}
+
+	for (int plane = 1; plane < plane_count; ++plane) {
+		uint64_t* copy = dst + (plane * words);
+		memcpy(copy + begin, dst + begin, (end - begin) * sizeof(*dst));
+	}
+}
+
+/*
+ * One plane generator per rule, each with the rule reduced to a single
+ * expression of the left, centre, and right neighbours of 64 cells at once.
+ *
+ * Only words `[begin, end)` are generated, reading the halo cells either side
+ * of the range from `src`.
+ */
+typedef void plane_fn(
+	uint64_t* dst, const uint64_t* src, size_t width,
+	size_t begin, size_t end
+);
+
+#define PLANE_KERNEL(rule, expression) \
+static void generate_plane_##rule( \
+	uint64_t* dst, const uint64_t* src, size_t width, \
+	size_t begin, size_t end \
+) { \
+	size_t last = eca_packed_words(width) - 1; \
+	unsigned int last_bit = (width - 1) % 64; \
+\
+	/* wrap around edges */ \
+	uint64_t carry = (begin == 0) ? (src[last] >> last_bit) & 1 \
+	                              : src[begin - 1] >> 63; \
+	size_t stop = (end > last) ? last : end; \
+\
+	for (size_t i = begin; i < stop; ++i) { \
+		uint64_t c = src[i]; \
+		uint64_t l = (c << 1) | carry; \
+		uint64_t r = (c >> 1) | (src[i + 1] << 63); \
+		carry = c >> 63; \
+\
+		(void)l; (void)r; \
+		dst[i] = (expression); \
+	} \
+\
+	if (end > last) { \
+		uint64_t c = src[last]; \
+		uint64_t l = (c << 1) | carry; \
+		uint64_t r = (c >> 1) | ((src[0] & 1) << last_bit); \
+		(void)l; (void)r; \
+		dst[last] = (expression) & last_word_mask(width); \
+	} \
+}
+
+ECA_RULES(PLANE_KERNEL)
+
+#undef PLANE_KERNEL
+
+#define PLANE_ENTRY(rule, expression) generate_plane_##rule,
+
+static plane_fn* const plane_fns[256] = {
+	ECA_RULES(PLANE_ENTRY)
+};
+
+#undef PLANE_ENTRY
+
+/* generates the next generation */
+void eca_packed_generate(
+	uint64_t* dst, const uint64_t* src, size_t width, int plane_count,
+	uint8_t rules[plane_count]
+) {
+	size_t words = eca_packed_words(width);
+	eca_packed_generate_range(
+		dst, src, width, plane_count, rules, 0, words
+	);
+}
+
+void eca_packed_generate_split(
+	uint64_t* dst, const uint64_t* src, size_t width, int plane_count,
+	uint8_t rules[plane_count]
+) {
+	size_t words = eca_packed_words(width);
+	eca_packed_generate_split_range(
+		dst, src, width, plane_count, rules, 0, words
+	);
+}
+
+void eca_packed_generate_directional(
+	uint64_t* dst, const uint64_t* src, size_t width, int plane_count,
+	uint8_t rules[plane_count]
+) {
+	size_t words = eca_packed_words(width);
+	eca_packed_generate_directional_range(
+		dst, src, width, plane_count, rules, 0, words
+	);
+}
+
+/* generates part of the next generation */
+void eca_packed_generate_range(
+	uint64_t* dst, const uint64_t* src, size_t width, int plane_count,
+	uint8_t rules[plane_count], size_t begin, size_t end
+) {
+	plane_fns[rules[0]](dst, src, width, begin, end);
+}
+
+void eca_packed_generate_split_range(
+	uint64_t* dst, const uint64_t* src, size_t width, int plane_count,
+	uint8_t rules[plane_count], size_t begin, size_t end
+) {
+	size_t words = eca_packed_words(width);
+	for (int plane = 0; plane < plane_count; ++plane) {
+		size_t offset = plane * words;
+		plane_fns[rules[plane]](
+			dst + offset, src + offset, width, begin, end
+		);
+	}
+}
+
+void eca_packed_generate_directional_range(
+	uint64_t* dst, const uint64_t* src, size_t width, int plane_count,
+	uint8_t rules[plane_count], size_t begin, size_t end
+) {
+	(void)plane_count;
+
+	size_t words = eca_packed_words(width);
+	plane_fns[rules[0]](dst, src, width, begin, end);
+
+	uint64_t* left   = dst + words;
+	uint64_t* centre = dst + (words * 2);
+	uint64_t* right  = dst + (words * 3);
+
+	size_t last = words - 1;
+	unsigned int last_bit = (width - 1) % 64;
+
+	/* parents of activated cells, wrapping around edges */
+	uint64_t carry = (begin == 0) ? (src[last] >> last_bit) & 1
+	                              : src[begin - 1] >> 63;
+	for (size_t i = begin; i < end; ++i) {
+		uint64_t c = src[i];
+		uint64_t next = (i == last) ? (src[0] & 1) << last_bit
+		                            : src[i + 1] << 63;
+
+		left[i]   = dst[i] & ((c << 1) | carry);
+		centre[i] = dst[i] & c;
+		right[i]  = dst[i] & ((c >> 1) | next);
+
+		carry = c >> 63;
+	}
+}
+
+void eca_packed_background(
+	uint64_t dst[], const uint64_t background[], int plane_count,
+	uint8_t rules[plane_count], eca_packed_range_fn* gen_fn
+) {
+	/* a short row of nothing but the background stays uniform */
+	enum { WORDS = 3 };
+	uint64_t src[ECA_PLANES_DIRECTIONAL * WORDS] = {0};
+	uint64_t next[ECA_PLANES_DIRECTIONAL * WORDS];
+
+	for (int plane = 0; plane < plane_count; ++plane) {
+		for (size_t i = 0; i < WORDS; ++i) {
+			src[(plane * WORDS) + i] = background[plane];
+		}
+	}
+
+	gen_fn(next, src, WORDS * 64, plane_count, rules, 0, WORDS);
+
+	for (int plane = 0; plane < plane_count; ++plane) {
+		dst[plane] = next[plane * WORDS];
+	}
+}
+
+void eca_packed_fill(
+	uint64_t* dst, size_t width, int plane_count,
+	const uint64_t background[plane_count], size_t begin, size_t end
+) {
+	size_t words = eca_packed_words(width);
+	for (int plane = 0; plane < plane_count; ++plane) {
+		uint64_t* row = dst + (plane * words);
+		for (size_t i = begin; i < end; ++i) {
+			row[i] = background[plane];
+		}
+		if (end == words) {
+			row[words - 1] &= last_word_mask(width);
+		}
+	}
+}
+
+/* cells of word `i` which differ from the background in any plane */
+static uint64_t difference(
+	const uint64_t* src, size_t width, int plane_count,
+	const uint64_t background[plane_count], size_t i
+) {
+	size_t words = eca_packed_words(width);
+
+	uint64_t diff = 0;
+	for (int plane = 0; plane < plane_count; ++plane) {
+		diff |= src[(plane * words) + i] ^ background[plane];
+	}
+
+	return (i == words - 1) ? diff & last_word_mask(width) : diff;
+}
+
+bool eca_packed_span(
+	const uint64_t* src, size_t width, int plane_count,
+	const uint64_t background[plane_count], size_t begin, size_t end,
+	size_t* first, size_t* last
+) {
+	size_t i = begin;
+	uint64_t diff = 0;
+	while (i < end && diff == 0) {
+		diff = difference(src, width, plane_count, background, i++);
+	}
+	if (diff == 0) {
+		return false;
+	}
+	*first = ((i - 1) * 64) + __builtin_ctzll(diff);
+
+	size_t j = end;
+	diff = 0;
+	while (diff == 0) {
+		diff = difference(src, width, plane_count, background, --j);
+	}
+	*last = (j * 64) + 63 - __builtin_clzll(diff);
+
+	return true;
+}
+
+/* the 64 cells starting at `position`, wrapping around the end of the row */
+static uint64_t get_cells(
+	const uint64_t* src, size_t width, size_t position
+) {
+	size_t word = position / 64;
+	unsigned int offset = position % 64;
+
+	if (position + 64 <= width) {
+		if (offset == 0) {
+			return src[word];
+		}
+		return (src[word] >> offset) | (src[word + 1] << (64 - offset));
+	}
+
+	uint64_t cells = 0;
+	for (unsigned int k = 0; k < 64; ++k) {
+		uint64_t bit = (src[position / 64] >> (position % 64)) & 1;
+		cells |= bit << k;
+		position = (position + 1 == width) ? 0 : position + 1;
+	}
+
+	return cells;
+}
+
+void eca_packed_advance_tile(
+	uint64_t* dst[], const uint64_t* src, size_t width, int plane_count,
+	uint8_t rules[plane_count], eca_packed_range_fn* gen_fn,
+	size_t begin, size_t end, int steps
+) {
+	enum { HALO = 1, SCRATCH_WORDS = ECA_TILE_WORDS + (2 * HALO) };
+
+	uint64_t scratch[2][ECA_PLANES_DIRECTIONAL * SCRATCH_WORDS];
+	uint64_t* current = scratch[0];
+	uint64_t* next = scratch[1];
+
+	/* the scratch row holds consecutive cells, even across the wrap */
+	size_t words = eca_packed_words(width);
+	size_t tile_words = end - begin;
+	size_t scratch_words = tile_words + (2 * HALO);
+	size_t scratch_width = scratch_words * 64;
+
+	size_t start = (begin * 64) % width;
+	start = (start + width - ((HALO * 64) % width)) % width;
+
+	for (int plane = 0; plane < plane_count; ++plane) {
+		const uint64_t* cells = src + (plane * words);
+		uint64_t* tile = current + (plane * scratch_words);
+		size_t position = start;
+
+		for (size_t k = 0; k < scratch_words; ++k) {
+			tile[k] = get_cells(cells, width, position);
+			position = (position + 64) % width;
+		}
+	}
+
+	/*
+	 * wrapping within the scratch row only disturbs the halo, which is
+	 * never stored
+	 */
+	for (int t = 1; t <= steps; ++t) {
+		gen_fn(
+			next, current, scratch_width, plane_count, rules,
+			0, scratch_words
+		);
+
+		uint64_t* tmp = current;
+		current = next;
+		next = tmp;
+
+		if (dst[t - 1] == NULL) {
+			continue;
+		}
+
+		for (int plane = 0; plane < plane_count; ++plane) {
+			uint64_t* row = dst[t - 1] + (plane * words);
+			const uint64_t* tile = current + (plane * scratch_words);
+			size_t size = tile_words * sizeof(*row);
+			memcpy(row + begin, tile + HALO, size);
+
+			if (end == words) {
+				row[words - 1] &= last_word_mask(width);
+			}
+		}
+	}
+}
+
+/* the parents a linear rule reads, and whether it inverts them */
+struct Linear {
+	bool left;
+	bool centre;
+	bool right;
+	bool inverted;
+};
+
+static bool linear_terms(uint8_t rule, struct Linear* linear) {
+	bool inverted = rule & 1;
+	linear->left = ((rule >> 4) & 1) != inverted;
+	linear->centre = ((rule >> 2) & 1) != inverted;
+	linear->right = ((rule >> 1) & 1) != inverted;
+	linear->inverted = inverted;
+
+	/* every neighbourhood must agree with the exclusive or of its parents */
+	for (int k = 0; k < 8; ++k) {
+		bool parents = (linear->left && (k & 4))
+		             ^ (linear->centre && (k & 2))
+		             ^ (linear->right && (k & 1));
+		if (((rule >> k) & 1) != (parents ^ inverted)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool eca_packed_linear(uint8_t rule) {
+	struct Linear linear;
+	return linear_terms(rule, &linear);
+}
+
+/* advances one plane by 2^k generations, `shift` is 2^k modulo the width */
+static void jump_plane(
+	uint64_t* dst, const uint64_t* src, size_t width,
+	const struct Linear* linear, size_t shift
+) {
+	size_t words = eca_packed_words(width);
+	size_t left = width - shift;
+
+	for (size_t i = 0; i < words; ++i) {
+		size_t position = i * 64;
+		uint64_t cells = linear->centre ? src[i] : 0;
+		if (linear->left) {
+			cells ^= get_cells(src, width, (position + left) % width);
+		}
+		if (linear->right) {
+			cells ^= get_cells(src, width, (position + shift) % width);
+		}
+
+		dst[i] = cells;
+	}
+
+	dst[words - 1] &= last_word_mask(width);
+}
+
+void eca_packed_jump(
+	uint64_t* row, uint64_t* scratch, size_t width, int plane_count,
+	uint8_t rules[plane_count], uint64_t steps
+) {
+	size_t words = eca_packed_words(width);
+
+	for (int plane = 0; plane < plane_count; ++plane) {
+		uint64_t* cells = row + (plane * words);
+		struct Linear linear;
+		linear_terms(rules[plane], &linear);
+
+		/* squaring the polynomial of the rule squares each of its terms */
+		size_t shift = 1 % width;
+		for (uint64_t bits = steps; bits != 0; bits >>= 1) {
+			if (bits & 1) {
+				jump_plane(scratch, cells, width, &linear, shift);
+				memcpy(cells, scratch, words * sizeof(*cells));
+			}
+			shift = (shift * 2) % width;
+		}
+
+		/*
+		 * the inversion of each generation is carried along with it, and
+		 * an activated row stays activated if the rule reads an odd number
+		 * of parents, or clears after a generation if it reads an even one
+		 */
+		bool odd = linear.left ^ linear.centre ^ linear.right;
+		bool invert = linear.inverted && (odd ? (steps & 1) : (steps > 0));
+		if (invert) {
+			for (size_t i = 0; i < words; ++i) {
+				cells[i] = ~cells[i];
+			}
+			cells[words - 1] &= last_word_mask(width);
+		}
+	}
+}
@@ -0,0 +1,231 @@
+#ifndef PACKED_H
+#define PACKED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * The packed engine stores one bit per cell, 64 cells per word. Cell `i` is
+ * bit `i % 64` of word `i / 64`, unused bits in the final word are kept clear.
+ *
+ * A row is made up of one or more "planes", each `eca_packed_words(width)`
+ * words long and stored one after another:
+ *
+ * - standard:    1 plane,  the cell state.
+ * - split:       3 planes, one per colour channel, each with its own rule.
+ * - directional: 4 planes, the cell state followed by the left, centre, and
+ *                right parent states of each activated cell.
+ */
+
+#define ECA_PLANES_STANDARD    1
+#define ECA_PLANES_SPLIT       3
+#define ECA_PLANES_DIRECTIONAL 4
+
+/**
+ * The number of words required to store a single plane of `width` cells.
+ */
+size_t eca_packed_words(size_t width);
+
+/* populates an initial generation, every plane is set identically */
+typedef void eca_packed_init_fn(uint64_t* dst, size_t width, int plane_count);
+
+/**
+ * Only the centre cell is activated.
+ */
+void eca_packed_initialise(uint64_t* dst, size_t width, int plane_count);
+
+/**
+ * Every other cell is activated.
+ */
+void eca_packed_initialise_alternate(
+	uint64_t* dst, size_t width, int plane_count
+);
+
+/**
+ * Cells are activated at "random", matching `eca_initialise_random`.
+ */
+void eca_packed_initialise_random(
+	uint64_t* dst, size_t width, int plane_count
+);
+
+/**
+ * Activates each cell with probability `density`, 64 cells at a time from a
+ * counter-based generator. Word `i` depends only on `seed` and `i`, so words
+ * `[begin, end)` may be filled apart from the rest of the row, by any thread
+ * or shard, and match a row filled all at once.
+ *
+ * - `density` is rounded to a multiple of 1/65536.
+ */
+void eca_packed_initialise_seeded(
+	uint64_t* dst, size_t width, int plane_count,
+	uint64_t seed, double density, size_t begin, size_t end
+);
+
+/* generates the next generation */
+typedef void eca_packed_gen_fn(
+	uint64_t* dst, const uint64_t* src, size_t width, int plane_count,
+	uint8_t rules[plane_count]
+);
+
+/**
+ * Standard generation.
+ *
+ * - only the first plane and rule are used.
+ */
+void eca_packed_generate(
+	uint64_t* dst, const uint64_t* src, size_t width, int plane_count,
+	uint8_t rules[plane_count]
+);
+
+/**
+ * Each plane is generated with its own rule.
+ */
+void eca_packed_generate_split(
+	uint64_t* dst, const uint64_t* src, size_t width, int plane_count,
+	uint8_t rules[plane_count]
+);
+
+/**
+ * The first plane is generated as standard, the remaining three record which
+ * parents were activated.
+ *
+ * - `plane_count` must be 4.
+ * - only the first rule provided is used.
+ */
+void eca_packed_generate_directional(
+	uint64_t* dst, const uint64_t* src, size_t width, int plane_count,
+	uint8_t rules[plane_count]
+);
+
+/* generates words `[begin, end)` of every plane of the next generation */
+typedef void eca_packed_range_fn(
+	uint64_t* dst, const uint64_t* src, size_t width, int plane_count,
+	uint8_t rules[plane_count], size_t begin, size_t end
+);
+
+/*
+ * The range generators below write only their own words of `dst`, reading
+ * the neighbouring words of `src`, so disjoint ranges of one generation can
+ * be generated at the same time.
+ */
+
+/**
+ * Standard generation of words `[begin, end)`, see `eca_packed_generate`.
+ */
+void eca_packed_generate_range(
+	uint64_t* dst, const uint64_t* src, size_t width, int plane_count,
+	uint8_t rules[plane_count], size_t begin, size_t end
+);
+
+/**
+ * Split generation of words `[begin, end)`, see `eca_packed_generate_split`.
+ */
+void eca_packed_generate_split_range(
+	uint64_t* dst, const uint64_t* src, size_t width, int plane_count,
+	uint8_t rules[plane_count], size_t begin, size_t end
+);
+
+/**
+ * Directional generation of words `[begin, end)`, see
+ * `eca_packed_generate_directional`.
+ */
+void eca_packed_generate_directional_range(
+	uint64_t* dst, const uint64_t* src, size_t width, int plane_count,
+	uint8_t rules[plane_count], size_t begin, size_t end
+);
+
+/*
+ * Light cones: a row which is only activated around a few cells, such as the
+ * standard initial generation, is otherwise in one "background" state, the
+ * same for every cell of a plane. The background evolves by itself, so only
+ * the cells within one cell of those which differ from it need generating,
+ * and the span of such cells grows by at most one cell each way a generation.
+ */
+
+/**
+ * The background of the next generation, from a `background` word of every
+ * plane which is either all clear or all set.
+ */
+void eca_packed_background(
+	uint64_t dst[], const uint64_t background[], int plane_count,
+	uint8_t rules[plane_count], eca_packed_range_fn* gen_fn
+);
+
+/**
+ * Sets words `[begin, end)` of every plane to its `background` word.
+ */
+void eca_packed_fill(
+	uint64_t* dst, size_t width, int plane_count,
+	const uint64_t background[plane_count], size_t begin, size_t end
+);
+
+/**
+ * Finds the first and last cells of words `[begin, end)` which differ from
+ * the `background` word of their plane in any plane.
+ *
+ * - returns false if every cell is in the background state.
+ */
+bool eca_packed_span(
+	const uint64_t* src, size_t width, int plane_count,
+	const uint64_t background[plane_count], size_t begin, size_t end,
+	size_t* first, size_t* last
+);
+
+/*
+ * Temporal blocking: a tile of words is copied into a small scratch row along
+ * with a halo of neighbouring cells, then advanced by many generations while
+ * it stays in cache. The light cone of a cell grows by one cell each way per
+ * generation, so a halo of one word keeps the tile exact for 64 generations.
+ * Tiles overlap only in the halo they read, so every tile of a band can be
+ * advanced at the same time.
+ */
+
+#define ECA_TILE_WORDS 1024
+#define ECA_TILE_STEPS 64
+
+/**
+ * Advances words `[begin, end)` of `src` by `steps` generations.
+ *
+ * - `end - begin` must be at most `ECA_TILE_WORDS`.
+ * - `steps` must be at most `ECA_TILE_STEPS`.
+ * - generation `t` is written to words `[begin, end)` of `dst[t - 1]`,
+ *   generations with a NULL row are not kept.
+ */
+void eca_packed_advance_tile(
+	uint64_t* dst[], const uint64_t* src, size_t width, int plane_count,
+	uint8_t rules[plane_count], eca_packed_range_fn* gen_fn,
+	size_t begin, size_t end, int steps
+);
+
+/*
+ * Linear rules: rules such as 90 and 150 set each cell to the exclusive or of
+ * some of its parents, and "affine" rules such as 105 to its inverse. A row
+ * is then a polynomial over GF(2), modulo `x^width - 1` as rows wrap, which
+ * each generation multiplies by the polynomial of the rule, so generation `n`
+ * is the row times the rule's polynomial to the power `n`. Squaring a
+ * polynomial over GF(2) squares each of its terms, so that power is a product
+ * of one shifted copy of the rule per set bit of `n`, and a row is advanced by
+ * `n` generations in `log2(n)` passes over its words.
+ */
+
+/* jumps cost a few passes over the row, so only pay off over longer runs */
+#define ECA_JUMP_STEPS 64
+
+/**
+ * Whether `rule` is linear or affine.
+ */
+bool eca_packed_linear(uint8_t rule);
+
+/**
+ * Advances `row` by `steps` generations at once, each plane with its own rule.
+ *
+ * - every rule must be linear, see `eca_packed_linear`.
+ * - `scratch` must hold one plane.
+ */
+void eca_packed_jump(
+	uint64_t* row, uint64_t* scratch, size_t width, int plane_count,
+	uint8_t rules[plane_count], uint64_t steps
+);
+
+#endif /* PACKED_H */
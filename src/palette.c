@@ -0,0 +1,292 @@
+#include "palette.h"
+
+#include "eca.h"
+#include "packed.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+/* fills the derived tables once the colours of each code are known */
+static void palette_finish(struct Palette* palette) {
+	for (int code = 0; code < 16; ++code) {
+		const uint8_t* rgb = palette->rgb[code];
+		unsigned int luma = (299 * rgb[0])
+		                  + (587 * rgb[1])
+		                  + (114 * rgb[2]);
+
+		palette->grey[code] = luma / 1000;
+		palette->mono[code] = palette->grey[code] >= 0x80;
+	}
+
+	/* codes beyond the planes of the palette never occur */
+	palette->colour_count = 0;
+	for (int code = 0; code < (1 << palette->plane_count); ++code) {
+		int n = 0;
+		while (
+			n < palette->colour_count
+			&& memcmp(palette->colours[n], palette->rgb[code], 3) != 0
+		) {
+			++n;
+		}
+
+		if (n == palette->colour_count) {
+			memcpy(palette->colours[n], palette->rgb[code], 3);
+			palette->colour_count += 1;
+		}
+		palette->index[code] = n;
+	}
+
+	for (int byte = 0; byte < 256; ++byte) {
+		uint8_t mono = 0;
+		uint8_t index = 0;
+		for (int k = 0; k < 8; ++k) {
+			int code = (byte >> k) & 1;
+			uint8_t* pixel = palette->rgb8[byte] + (k * 3);
+			memcpy(pixel, palette->rgb[code], 3);
+			palette->grey8[byte][k] = palette->grey[code];
+			mono |= palette->mono[code] << (7 - k);
+			index |= (palette->index[code] & 1) << (7 - k);
+		}
+		palette->mono8[byte] = mono;
+		palette->index8[byte] = index;
+	}
+}
+
+void palette_standard(struct Palette* palette) {
+	memset(palette, 0, sizeof(*palette));
+	palette->plane_count = ECA_PLANES_STANDARD;
+
+	memset(palette->rgb[0], 0xff, 3);
+	memset(palette->rgb[1], 0x00, 3);
+
+	palette_finish(palette);
+}
+
+void palette_split(struct Palette* palette) {
+	memset(palette, 0, sizeof(*palette));
+	palette->plane_count = ECA_PLANES_SPLIT;
+
+	for (int code = 0; code < 8; ++code) {
+		for (int channel = 0; channel < 3; ++channel) {
+			bool set = (code >> channel) & 1;
+			palette->rgb[code][channel] = set ? ECA_ON : ECA_OFF;
+		}
+	}
+
+	palette_finish(palette);
+}
+
+void palette_directional(struct Palette* palette) {
+	memset(palette, 0, sizeof(*palette));
+	palette->plane_count = ECA_PLANES_DIRECTIONAL;
+
+	for (int code = 1; code < 16; code += 2) {
+		for (int channel = 0; channel < 3; ++channel) {
+			bool parent = (code >> (channel + 1)) & 1;
+			palette->rgb[code][channel] = parent ? ECA_ON : ECA_HALF;
+		}
+	}
+
+	palette_finish(palette);
+}
+
+void palette_states(struct Palette* palette, int plane_count) {
+	memset(palette, 0, sizeof(*palette));
+	palette->plane_count = plane_count;
+
+	for (int code = 1; code < 16; code += 2) {
+		memset(palette->rgb[code], 0xff, 3);
+	}
+
+	palette_finish(palette);
+}
+
+enum Format palette_index_format(const struct Palette* palette) {
+	if (palette->colour_count <= 2) {
+		return FORMAT_INDEX1;
+	}
+	if (palette->colour_count <= 4) {
+		return FORMAT_INDEX2;
+	}
+
+	return FORMAT_INDEX4;
+}
+
+int palette_index_bits(enum Format format) {
+	switch (format) {
+		default:            return 0;
+		case FORMAT_INDEX1: return 1;
+		case FORMAT_INDEX2: return 2;
+		case FORMAT_INDEX4: return 4;
+	}
+}
+
+size_t palette_row_size(enum Format format, size_t width) {
+	switch (format) {
+		default:
+		case FORMAT_RGB:  return width * 3;
+		case FORMAT_GREY: return width;
+		case FORMAT_MONO: return (width + 7) / 8;
+		case FORMAT_INDEX1:
+		case FORMAT_INDEX2:
+		case FORMAT_INDEX4: {
+			return ((width * palette_index_bits(format)) + 7) / 8;
+		}
+	}
+}
+
+/* spreads the bits of a byte across the bytes of a word */
+static uint64_t spread(uint8_t byte) {
+	uint64_t word = 0;
+	for (int k = 0; k < 8; ++k) {
+		word |= (uint64_t)((byte >> k) & 1) << (k * 8);
+	}
+
+	return word;
+}
+
+/* writes up to 8 cells from their codes, one per byte of `codes` */
+static void put_codes(
+	const struct Palette* palette, enum Format format,
+	uint8_t* dst, size_t i, uint64_t codes, size_t count
+) {
+	switch (format) {
+		default:
+		case FORMAT_RGB: {
+			for (size_t k = 0; k < count; ++k) {
+				int code = (codes >> (k * 8)) & 0xff;
+				memcpy(dst + ((i + k) * 3), palette->rgb[code], 3);
+			}
+			break;
+		}
+		case FORMAT_GREY: {
+			for (size_t k = 0; k < count; ++k) {
+				int code = (codes >> (k * 8)) & 0xff;
+				dst[i + k] = palette->grey[code];
+			}
+			break;
+		}
+		case FORMAT_MONO: {
+			/* `i` is always a multiple of 8 */
+			uint8_t mono = 0;
+			for (size_t k = 0; k < count; ++k) {
+				int code = (codes >> (k * 8)) & 0xff;
+				mono |= palette->mono[code] << (7 - k);
+			}
+			dst[i / 8] = mono;
+			break;
+		}
+		case FORMAT_INDEX1:
+		case FORMAT_INDEX2:
+		case FORMAT_INDEX4: {
+			/* `i` is a multiple of 8, so the cells fill whole bytes */
+			int bits = palette_index_bits(format);
+			uint8_t* bytes = dst + ((i * bits) / 8);
+			memset(bytes, 0, ((count * bits) + 7) / 8);
+
+			for (size_t k = 0; k < count; ++k) {
+				int code = (codes >> (k * 8)) & 0xff;
+				size_t bit = k * bits;
+				bytes[bit / 8] |= palette->index[code] \
+					<< (8 - bits - (bit % 8));
+			}
+			break;
+		}
+	}
+}
+
+void palette_apply(
+	const struct Palette* palette, enum Format format,
+	uint8_t* dst, const uint64_t* src, size_t width
+) {
+	palette_apply_range(palette, format, dst, src, width, 0, width);
+}
+
+void palette_apply_range(
+	const struct Palette* palette, enum Format format,
+	uint8_t* dst, const uint64_t* src, size_t width,
+	size_t begin, size_t end
+) {
+	size_t words = eca_packed_words(width);
+
+	for (size_t i = begin; i < end; i += 8) {
+		size_t count = (end - i < 8) ? end - i : 8;
+
+		/* single planes are looked up a byte of cells at a time */
+		bool lookup = format != FORMAT_INDEX2 && format != FORMAT_INDEX4;
+		if (palette->plane_count == 1 && count == 8 && lookup) {
+			uint8_t bits = src[i / 64] >> (i % 64);
+			switch (format) {
+				default:
+				case FORMAT_RGB:
+					memcpy(dst + (i * 3), palette->rgb8[bits], 24);
+					break;
+				case FORMAT_GREY:
+					memcpy(dst + i, palette->grey8[bits], 8);
+					break;
+				case FORMAT_MONO:
+					dst[i / 8] = palette->mono8[bits];
+					break;
+				case FORMAT_INDEX1:
+					dst[i / 8] = palette->index8[bits];
+					break;
+			}
+			continue;
+		}
+
+		uint64_t codes = 0;
+		for (int plane = 0; plane < palette->plane_count; ++plane) {
+			const uint64_t* cells = src + (plane * words);
+			uint8_t bits = cells[i / 64] >> (i % 64);
+			codes |= spread(bits) << plane;
+		}
+
+		put_codes(palette, format, dst, i, codes, count);
+	}
+}
+
+void palette_apply_bytes(
+	const struct Palette* palette, enum Format format,
+	uint8_t* dst, const uint8_t* src, size_t width, int channel_count
+) {
+	for (size_t i = 0; i < width; i += 8) {
+		size_t count = (width - i < 8) ? width - i : 8;
+
+		/* read every cell before writing, `dst` may alias `src` */
+		uint64_t codes = 0;
+		for (size_t k = 0; k < count; ++k) {
+			const uint8_t* pixel = src + ((i + k) * channel_count);
+			uint64_t code = 0;
+
+			if (palette->plane_count == ECA_PLANES_DIRECTIONAL) {
+				for (int channel = 0; channel < 3; ++channel) {
+					code |= (pixel[channel] != ECA_OFF);
+					code |= (uint64_t)(pixel[channel] == ECA_ON) \
+						<< (channel + 1);
+				}
+			} else {
+				for (int n = 0; n < palette->plane_count; ++n) {
+					code |= (uint64_t)(pixel[n] == ECA_ON) << n;
+				}
+			}
+
+			codes |= code << (k * 8);
+		}
+
+		put_codes(palette, format, dst, i, codes, count);
+	}
+}
+
+void palette_expand(
+	const struct Palette* palette, enum Format format,
+	uint8_t* dst, const uint8_t* src, size_t width
+) {
+	int bits = palette_index_bits(format);
+	int mask = (1 << bits) - 1;
+
+	for (size_t i = 0; i < width; ++i) {
+		size_t bit = i * bits;
+		int index = (src[bit / 8] >> (8 - bits - (bit % 8))) & mask;
+		memcpy(dst + (i * 3), palette->colours[index], 3);
+	}
+}
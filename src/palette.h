@@ -0,0 +1,127 @@
+#ifndef PALETTE_H
+#define PALETTE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * A palette turns rows of cell states into pixels.
+ *
+ * Each cell is first reduced to a small code, bit `n` of which is taken from
+ * plane `n` of a packed row:
+ *
+ * - standard:    bit 0 is the cell state.
+ * - split:       bits 0, 1, and 2 are the red, green, and blue cell states.
+ * - directional: bit 0 is the cell state, bits 1, 2, and 3 are the left,
+ *                centre, and right parents.
+ *
+ * The code is then looked up to give the colour in the requested format.
+ *
+ * The index formats give the position of each colour in the list of distinct
+ * colours of the palette, as an indexed PNG does, see `palette_index_format`.
+ */
+
+enum Format {
+	FORMAT_RGB    = 0, /* 3 bytes per cell */
+	FORMAT_GREY   = 1, /* 1 byte per cell */
+	FORMAT_MONO   = 2, /* 1 bit per cell, most significant bit first */
+	FORMAT_INDEX1 = 3, /* 1 bit index per cell, most significant first */
+	FORMAT_INDEX2 = 4, /* 2 bit index per cell, most significant first */
+	FORMAT_INDEX4 = 5  /* 4 bit index per cell, most significant first */
+};
+
+struct Palette {
+	int plane_count;
+
+	uint8_t rgb[16][3];
+	uint8_t grey[16];
+	uint8_t mono[16];
+
+	/* the distinct colours, in order of their lowest code */
+	int colour_count;
+	uint8_t colours[16][3];
+	uint8_t index[16];
+
+	/* single plane rows, looked up 8 cells at a time */
+	uint8_t rgb8[256][24];
+	uint8_t grey8[256][8];
+	uint8_t mono8[256];
+	uint8_t index8[256];
+};
+
+/**
+ * Black cells on a white background.
+ */
+void palette_standard(struct Palette* palette);
+
+/**
+ * Each plane is shown in its own colour channel.
+ */
+void palette_split(struct Palette* palette);
+
+/**
+ * Activated cells are coloured by parent; a channel is bright if its parent
+ * was activated and dim otherwise.
+ */
+void palette_directional(struct Palette* palette);
+
+/**
+ * The state of the first plane of each cell, white where it is activated, so
+ * the mono format has a bit set for each activated cell.
+ */
+void palette_states(struct Palette* palette, int plane_count);
+
+/**
+ * The smallest index format which holds every colour of `palette`.
+ */
+enum Format palette_index_format(const struct Palette* palette);
+
+/**
+ * The bits per cell of an index format, or 0 for the other formats.
+ */
+int palette_index_bits(enum Format format);
+
+/**
+ * The number of bytes in a row of `width` cells.
+ */
+size_t palette_row_size(enum Format format, size_t width);
+
+/**
+ * Colours a packed row, see `packed.h`.
+ */
+void palette_apply(
+	const struct Palette* palette, enum Format format,
+	uint8_t* dst, const uint64_t* src, size_t width
+);
+
+/**
+ * Colours cells `[begin, end)` of a packed row, writing to the same place in
+ * `dst` as `palette_apply` would.
+ *
+ * - `begin` must be a multiple of 8.
+ */
+void palette_apply_range(
+	const struct Palette* palette, enum Format format,
+	uint8_t* dst, const uint64_t* src, size_t width,
+	size_t begin, size_t end
+);
+
+/**
+ * Colours a row in the byte layout, see `eca.h`.
+ *
+ * - `dst` may be the same as `src`.
+ */
+void palette_apply_bytes(
+	const struct Palette* palette, enum Format format,
+	uint8_t* dst, const uint8_t* src, size_t width, int channel_count
+);
+
+/**
+ * Colours a row of an index format as RGB.
+ */
+void palette_expand(
+	const struct Palette* palette, enum Format format,
+	uint8_t* dst, const uint8_t* src, size_t width
+);
+
+#endif /* PALETTE_H */
@@ -0,0 +1,521 @@
+#include "png.h"
+
+#include "pool.h"
+#include "stats.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zlib.h>
+
+/* size of the buffer for compressed data, and so the largest IDAT chunk */
+#define CHUNK_SIZE (256 * 1024)
+
+/* rows are gathered into blocks of about this many bytes */
+#define BLOCK_SIZE (256 * 1024)
+
+/* how far back deflate may refer, the end of a block primes the next */
+#define WINDOW_SIZE (32 * 1024)
+
+/*
+ * A run of rows which is filtered and deflated on its own, as pigz does.
+ *
+ * Each block is a raw deflate stream ending on a byte boundary, primed with
+ * the end of the block before it, so the blocks of a PNG are compressed in
+ * parallel and written one after another as a single zlib stream.
+ */
+struct PngBlock {
+	z_stream stream;
+	size_t row_count;
+
+	uint8_t* raw;           /* the unfiltered rows */
+	uint8_t* filtered;      /* the rows, each after its filter type */
+	uint8_t* candidates[5]; /* a candidate row for each filter type */
+
+	uint8_t* output;
+	size_t output_size;
+	size_t output_capacity;
+
+	uint32_t adler;         /* checksum of the filtered rows */
+	bool final;             /* the last block of the image */
+	bool ok;
+};
+
+struct PngWriter {
+	FILE* file;
+	bool is_stdout;
+	struct Pool* pool;
+
+	uint32_t height;
+	uint32_t rows_written;
+
+	size_t row_size;      /* bytes per row, without the filter type */
+	size_t pixel_size;    /* bytes per pixel, at least 1 */
+
+	struct PngBlock* blocks;
+	int block_count;      /* blocks gathered before they are compressed */
+	size_t block_rows;    /* rows per block */
+	int block;            /* the block being gathered */
+
+	uint8_t* previous;    /* the last unfiltered row compressed */
+	uint8_t* window;      /* the last filtered bytes compressed */
+	size_t window_size;
+
+	uint32_t adler;       /* checksum of every block compressed */
+	int level;
+	bool started;
+
+	uint8_t* output;
+	size_t output_size;
+};
+
+static void put_u32(uint8_t* dst, uint32_t n) {
+	dst[0] = n >> 24;
+	dst[1] = n >> 16;
+	dst[2] = n >>  8;
+	dst[3] = n;
+}
+
+static bool write_chunk(
+	FILE* file, const char* type, const uint8_t* data, uint32_t size
+) {
+	uint8_t header[8];
+	put_u32(header, size);
+	memcpy(header + 4, type, 4);
+
+	/* zlib resets the checksum when given no data */
+	uint32_t crc = crc32(0, header + 4, 4);
+	if (size > 0) {
+		crc = crc32(crc, data, size);
+	}
+
+	uint8_t footer[4];
+	put_u32(footer, crc);
+	stats_count(STATS_BYTES_WRITTEN, 12 + (uint64_t)size);
+
+	return fwrite(header, 1, 8, file) == 8
+	    && fwrite(data, 1, size, file) == size
+	    && fwrite(footer, 1, 4, file) == 4;
+}
+
+static void png_free(struct PngWriter* png) {
+	/* streams which were never initialised are ignored by zlib */
+	for (int n = 0; png->blocks != NULL && n < png->block_count; ++n) {
+		struct PngBlock* block = &png->blocks[n];
+
+		deflateEnd(&block->stream);
+		free(block->raw);
+		free(block->filtered);
+		for (int i = 0; i < 5; ++i) {
+			free(block->candidates[i]);
+		}
+		free(block->output);
+	}
+
+	if (png->pool != NULL) {
+		pool_destroy(png->pool);
+	}
+	free(png->blocks);
+	free(png->previous);
+	free(png->window);
+	free(png->output);
+	free(png);
+}
+
+static bool block_init(
+	struct PngBlock* block, size_t rows, size_t row_size, int level
+) {
+	block->raw = malloc(rows * row_size);
+	block->filtered = malloc(rows * (row_size + 1));
+	for (int i = 0; i < 5; ++i) {
+		block->candidates[i] = malloc(row_size + 1);
+	}
+
+	/* room for a sync flush, which ends with an empty stored block */
+	block->output_capacity = compressBound(rows * (row_size + 1)) + 64;
+	block->output = malloc(block->output_capacity);
+
+	bool ok = block->raw != NULL && block->filtered != NULL
+	       && block->output != NULL;
+	for (int i = 0; i < 5; ++i) {
+		ok = ok && block->candidates[i] != NULL;
+	}
+
+	/* raw deflate, the zlib header and checksum are written by the writer */
+	return ok && deflateInit2(
+		&block->stream, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY
+	) == Z_OK;
+}
+
+struct PngWriter* png_open(
+	const char* filename, uint32_t width, uint32_t height,
+	enum PngColour colour, int bit_depth, int level, int threads
+) {
+	struct PngWriter* png = calloc(1, sizeof(*png));
+	if (png == NULL) {
+		return NULL;
+	}
+
+	int channels = (colour == PNG_RGB) ? 3 : 1;
+	size_t bits_per_pixel = channels * bit_depth;
+
+	png->height = height;
+	png->row_size = ((width * bits_per_pixel) + 7) / 8;
+	png->pixel_size = (bits_per_pixel + 7) / 8;
+	png->level = level;
+
+	/* a block holds at least one row, and no more blocks than the image */
+	png->block_rows = BLOCK_SIZE / png->row_size;
+	if (png->block_rows < 1) {
+		png->block_rows = 1;
+	}
+	size_t block_limit = (height + png->block_rows - 1) / png->block_rows;
+	png->block_count = ((size_t)threads < block_limit) ? threads
+	                                                   : (int)block_limit;
+
+	png->previous = calloc(png->row_size, 1);
+	png->window = malloc(WINDOW_SIZE);
+	png->output = malloc(CHUNK_SIZE);
+	png->blocks = calloc(png->block_count, sizeof(*png->blocks));
+	png->pool = pool_create(png->block_count);
+
+	bool ok = png->previous != NULL && png->window != NULL
+	       && png->output != NULL && png->blocks != NULL
+	       && png->pool != NULL;
+
+	for (int n = 0; ok && n < png->block_count; ++n) {
+		ok = block_init(
+			&png->blocks[n], png->block_rows, png->row_size, level
+		);
+	}
+
+	if (!ok) {
+		png_free(png);
+		return NULL;
+	}
+
+	png->is_stdout = strcmp(filename, "-") == 0;
+	png->file = png->is_stdout ? stdout : fopen(filename, "wb");
+	if (png->file == NULL) {
+		png_free(png);
+		return NULL;
+	}
+
+	static const uint8_t signature[8] = {
+		0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'
+	};
+
+	uint8_t header[13];
+	put_u32(header, width);
+	put_u32(header + 4, height);
+	header[8]  = bit_depth;
+	header[9]  = colour;
+	header[10] = 0; /* deflate */
+	header[11] = 0; /* adaptive filtering */
+	header[12] = 0; /* no interlace */
+
+	ok = fwrite(signature, 1, 8, png->file) == 8
+	  && write_chunk(png->file, "IHDR", header, 13);
+	stats_count(STATS_BYTES_WRITTEN, 8);
+
+	if (!ok) {
+		png_close(png);
+		return NULL;
+	}
+
+	stats_count(STATS_IMAGES, 1);
+	return png;
+}
+
+bool png_write_palette(
+	struct PngWriter* png, const uint8_t* colours, int colour_count
+) {
+	return write_chunk(png->file, "PLTE", colours, colour_count * 3);
+}
+
+/* appends compressed data, writing an IDAT chunk whenever output fills */
+static bool emit(struct PngWriter* png, const uint8_t* data, size_t size) {
+	while (size > 0) {
+		size_t count = CHUNK_SIZE - png->output_size;
+		if (count > size) {
+			count = size;
+		}
+
+		memcpy(png->output + png->output_size, data, count);
+		png->output_size += count;
+		data += count;
+		size -= count;
+
+		if (png->output_size == CHUNK_SIZE) {
+			if (!write_chunk(png->file, "IDAT", png->output, CHUNK_SIZE)) {
+				return false;
+			}
+			png->output_size = 0;
+		}
+	}
+
+	return true;
+}
+
+static uint8_t paeth(int a, int b, int c) {
+	int p = a + b - c;
+	int pa = abs(p - a);
+	int pb = abs(p - b);
+	int pc = abs(p - c);
+
+	/* written as selects so the filter loop can be vectorised */
+	int bc = (pb <= pc) ? b : c;
+	return (pa <= pb && pa <= pc) ? a : bc;
+}
+
+/* the sum of the filtered bytes as signed values, lower compresses better */
+static unsigned long filter_cost(const uint8_t* line, size_t size) {
+	unsigned long sum = 0;
+	for (size_t x = 0; x < size; ++x) {
+		unsigned int byte = line[x];
+		sum += (byte < 128) ? byte : 256 - byte;
+	}
+
+	return sum;
+}
+
+/* filters `row` with each filter type, returning the best candidate */
+static const uint8_t* filter_row(
+	const struct PngWriter* png, uint8_t* const* candidates,
+	const uint8_t* row, const uint8_t* up
+) {
+	size_t size = png->row_size;
+	size_t bpp = png->pixel_size;
+
+	uint8_t* none  = candidates[0] + 1;
+	uint8_t* sub   = candidates[1] + 1;
+	uint8_t* above = candidates[2] + 1;
+	uint8_t* avg   = candidates[3] + 1;
+	uint8_t* pae   = candidates[4] + 1;
+
+	memcpy(none, row, size);
+
+	for (size_t x = 0; x < bpp && x < size; ++x) {
+		sub[x]   = row[x];
+		above[x] = row[x] - up[x];
+		avg[x]   = row[x] - (up[x] >> 1);
+		pae[x]   = row[x] - up[x];
+	}
+
+	for (size_t x = bpp; x < size; ++x) {
+		int a = row[x - bpp];
+		int b = up[x];
+		int c = up[x - bpp];
+
+		sub[x]   = row[x] - a;
+		above[x] = row[x] - b;
+		avg[x]   = row[x] - ((a + b) >> 1);
+		pae[x]   = row[x] - paeth(a, b, c);
+	}
+
+	int best = 0;
+	unsigned long best_cost = (unsigned long)-1;
+
+	for (int type = 0; type < 5; ++type) {
+		candidates[type][0] = type;
+
+		unsigned long cost = filter_cost(candidates[type] + 1, size);
+		if (cost < best_cost) {
+			best_cost = cost;
+			best = type;
+		}
+	}
+
+	return candidates[best];
+}
+
+static size_t filtered_size(
+	const struct PngWriter* png, const struct PngBlock* block
+) {
+	return block->row_count * (png->row_size + 1);
+}
+
+static void filter_task(void* context, size_t index) {
+	struct PngWriter* png = context;
+	struct PngBlock* block = &png->blocks[index];
+	size_t size = png->row_size;
+
+	/* the row above the block is the last of the block before */
+	const uint8_t* up = png->previous;
+	if (index > 0) {
+		const struct PngBlock* before = &png->blocks[index - 1];
+		up = before->raw + ((before->row_count - 1) * size);
+	}
+
+	for (size_t i = 0; i < block->row_count; ++i) {
+		const uint8_t* row = block->raw + (i * size);
+		const uint8_t* best = filter_row(png, block->candidates, row, up);
+
+		memcpy(block->filtered + (i * (size + 1)), best, size + 1);
+		up = row;
+	}
+}
+
+static void deflate_task(void* context, size_t index) {
+	struct PngWriter* png = context;
+	struct PngBlock* block = &png->blocks[index];
+	z_stream* stream = &block->stream;
+
+	size_t size = filtered_size(png, block);
+	block->adler = adler32(adler32(0, NULL, 0), block->filtered, size);
+
+	/* primed with as much as is at hand of what comes before the block */
+	const uint8_t* window = png->window;
+	size_t window_size = png->window_size;
+	if (index > 0) {
+		const struct PngBlock* before = &png->blocks[index - 1];
+		size_t before_size = filtered_size(png, before);
+
+		window_size = (before_size < WINDOW_SIZE) ? before_size
+		                                          : WINDOW_SIZE;
+		window = before->filtered + (before_size - window_size);
+	}
+
+	deflateReset(stream);
+	block->ok = window_size == 0
+	         || deflateSetDictionary(stream, window, window_size) == Z_OK;
+
+	stream->next_in = block->filtered;
+	stream->avail_in = size;
+	stream->next_out = block->output;
+	stream->avail_out = block->output_capacity;
+
+	int status = deflate(stream, block->final ? Z_FINISH : Z_SYNC_FLUSH);
+	bool done = block->final ? status == Z_STREAM_END : status == Z_OK;
+
+	block->ok = block->ok && done && stream->avail_in == 0;
+	block->output_size = block->output_capacity - stream->avail_out;
+}
+
+/* keeps the end of the filtered rows of `block` to prime the next */
+static void keep_window(struct PngWriter* png, const struct PngBlock* block) {
+	size_t size = filtered_size(png, block);
+	const uint8_t* filtered = block->filtered;
+
+	if (size >= WINDOW_SIZE) {
+		memcpy(png->window, filtered + size - WINDOW_SIZE, WINDOW_SIZE);
+		png->window_size = WINDOW_SIZE;
+		return;
+	}
+
+	/* a short block follows on from the end of the window */
+	size_t kept = WINDOW_SIZE - size;
+	if (kept > png->window_size) {
+		kept = png->window_size;
+	}
+
+	memmove(png->window, png->window + png->window_size - kept, kept);
+	memcpy(png->window + kept, filtered, size);
+	png->window_size = kept + size;
+}
+
+/* filters and deflates the gathered blocks, then writes them in order */
+static bool compress_blocks(struct PngWriter* png, bool final) {
+	int count = png->block;
+	if (count < png->block_count && png->blocks[count].row_count > 0) {
+		count += 1;
+	}
+
+	png->blocks[count - 1].final = final;
+
+	pool_run(png->pool, filter_task, png, count);
+	pool_run(png->pool, deflate_task, png, count);
+
+	bool ok = true;
+	if (!png->started) {
+		/* a 32 KiB window, and the level flagged as zlib would */
+		int flags = (png->level < 2) ? 0 : (png->level < 6) ? 1
+		          : (png->level == 6) ? 2 : 3;
+		uint8_t header[2] = {0x78, flags << 6};
+		header[1] += 31 - (((header[0] << 8) | header[1]) % 31);
+
+		ok = emit(png, header, 2);
+		png->adler = adler32(0, NULL, 0);
+		png->started = true;
+	}
+
+	for (int n = 0; n < count; ++n) {
+		const struct PngBlock* block = &png->blocks[n];
+
+		ok = ok && block->ok && emit(png, block->output, block->output_size);
+		png->adler = adler32_combine(
+			png->adler, block->adler, filtered_size(png, block)
+		);
+		keep_window(png, block);
+	}
+
+	const struct PngBlock* last = &png->blocks[count - 1];
+	memcpy(
+		png->previous,
+		last->raw + ((last->row_count - 1) * png->row_size),
+		png->row_size
+	);
+
+	for (int n = 0; n < count; ++n) {
+		png->blocks[n].row_count = 0;
+	}
+	png->block = 0;
+
+	return ok;
+}
+
+bool png_write_row(struct PngWriter* png, const uint8_t* row) {
+	if (png->rows_written >= png->height) {
+		return false;
+	}
+
+	uint64_t begin = stats_clock();
+
+	struct PngBlock* block = &png->blocks[png->block];
+	memcpy(
+		block->raw + (block->row_count * png->row_size), row, png->row_size
+	);
+	block->row_count += 1;
+	png->rows_written += 1;
+
+	if (block->row_count == png->block_rows) {
+		png->block += 1;
+	}
+
+	/* the last block is left for `png_close` to end the stream with */
+	bool ok = true;
+	if (png->block == png->block_count && png->rows_written < png->height) {
+		ok = compress_blocks(png, false);
+	}
+
+	stats_end(STATS_ENCODE, begin);
+	stats_count(STATS_ROWS, 1);
+
+	return ok;
+}
+
+bool png_close(struct PngWriter* png) {
+	uint64_t begin = stats_clock();
+	bool ok = png->rows_written == png->height;
+
+	if (ok) {
+		uint8_t footer[4];
+		ok = compress_blocks(png, true);
+		put_u32(footer, png->adler);
+
+		ok = ok && emit(png, footer, 4)
+		  && write_chunk(png->file, "IDAT", png->output, png->output_size)
+		  && write_chunk(png->file, "IEND", NULL, 0);
+	}
+
+	int closed = png->is_stdout ? fflush(png->file) : fclose(png->file);
+	if (closed != 0) {
+		ok = false;
+	}
+
+	png_free(png);
+	stats_end(STATS_ENCODE, begin);
+
+	return ok;
+}
@@ -0,0 +1,56 @@
+#ifndef PNG_H
+#define PNG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * A PNG writer which takes one row at a time. Rows are gathered into blocks
+ * of about 256 KiB, one for each thread, which are then filtered and deflated
+ * in parallel and written out in IDAT chunks, so only a few blocks are ever
+ * held in memory.
+ */
+
+enum PngColour {
+	PNG_GREY    = 0,
+	PNG_RGB     = 2,
+	PNG_INDEXED = 3
+};
+
+struct PngWriter;
+
+/**
+ * Creates `filename`, or uses stdout if it is "-", and writes the header.
+ *
+ * - `bit_depth` is 8 for `PNG_RGB`, and 1, 2, 4, or 8 otherwise.
+ * - `level` is a zlib compression level, 0 to 9.
+ * - `threads` is the most blocks compressed at once.
+ * - returns NULL on failure.
+ */
+struct PngWriter* png_open(
+	const char* filename, uint32_t width, uint32_t height,
+	enum PngColour colour, int bit_depth, int level, int threads
+);
+
+/**
+ * Writes the palette of an indexed image, before the first row.
+ */
+bool png_write_palette(
+	struct PngWriter* png, const uint8_t* colours, int colour_count
+);
+
+/**
+ * Writes the next row, rows are given from top to bottom.
+ */
+bool png_write_row(struct PngWriter* png, const uint8_t* row);
+
+/**
+ * Finishes the image and closes the file.
+ *
+ * - fails if fewer rows were written than the height of the image.
+ * - the writer is freed either way.
+ */
+bool png_close(struct PngWriter* png);
+
+#endif /* PNG_H */
@@ -0,0 +1,153 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "pnm.h"
+
+#include "stats.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* rows are gathered until this many bytes before they are written */
+#define BUFFER_SIZE (1024 * 1024)
+
+struct PnmWriter {
+	int fd;
+	bool is_stdout;
+	enum PnmKind kind;
+
+	size_t height;
+	size_t rows_written;
+	size_t row_size;
+
+	uint8_t* buffer;
+	size_t buffered;
+	bool ok;
+};
+
+/* writes all of `data`, as `write` may take only part of it */
+static bool write_all(int fd, const uint8_t* data, size_t size) {
+	while (size > 0) {
+		ssize_t count = write(fd, data, size);
+		if (count < 0 && errno == EINTR) {
+			continue;
+		}
+		if (count <= 0) {
+			return false;
+		}
+
+		stats_count(STATS_BYTES_WRITTEN, count);
+		data += count;
+		size -= count;
+	}
+
+	return true;
+}
+
+static bool flush(struct PnmWriter* pnm) {
+	bool ok = write_all(pnm->fd, pnm->buffer, pnm->buffered);
+	pnm->buffered = 0;
+
+	return ok;
+}
+
+struct PnmWriter* pnm_open(
+	const char* filename, size_t width, size_t height, enum PnmKind kind
+) {
+	struct PnmWriter* pnm = calloc(1, sizeof(*pnm));
+	if (pnm == NULL) {
+		return NULL;
+	}
+
+	pnm->kind = kind;
+	pnm->height = height;
+	pnm->row_size = (kind == PNM_BITMAP) ? (width + 7) / 8 : width * 3;
+	pnm->buffer = malloc(BUFFER_SIZE);
+	pnm->ok = true;
+
+	pnm->is_stdout = strcmp(filename, "-") == 0;
+	pnm->fd = pnm->is_stdout ? STDOUT_FILENO : open(
+		filename, O_WRONLY | O_CREAT | O_TRUNC, 0666
+	);
+
+	if (pnm->buffer == NULL || pnm->fd < 0) {
+		if (pnm->fd >= 0 && !pnm->is_stdout) {
+			close(pnm->fd);
+		}
+		free(pnm->buffer);
+		free(pnm);
+		return NULL;
+	}
+
+	int size = snprintf(
+		(char*)pnm->buffer, BUFFER_SIZE, "P%d\n%zu %zu\n%s",
+		kind, width, height, (kind == PNM_PIXMAP) ? "255\n" : ""
+	);
+	pnm->buffered = size;
+
+	stats_count(STATS_IMAGES, 1);
+	return pnm;
+}
+
+bool pnm_write_row(struct PnmWriter* pnm, const uint8_t* row) {
+	if (pnm->rows_written >= pnm->height || !pnm->ok) {
+		return false;
+	}
+
+	uint64_t begin = stats_clock();
+	size_t size = pnm->row_size;
+	pnm->rows_written += 1;
+
+	/* a pixmap row larger than the buffer is written without a copy */
+	if (pnm->kind == PNM_PIXMAP && size > BUFFER_SIZE) {
+		pnm->ok = flush(pnm) && write_all(pnm->fd, row, size);
+		size = 0;
+	}
+
+	while (pnm->ok && size > 0) {
+		size_t count = BUFFER_SIZE - pnm->buffered;
+		if (count > size) {
+			count = size;
+		}
+
+		uint8_t* dst = pnm->buffer + pnm->buffered;
+		if (pnm->kind == PNM_BITMAP) {
+			for (size_t x = 0; x < count; ++x) {
+				dst[x] = ~row[x];
+			}
+		} else {
+			memcpy(dst, row, count);
+		}
+
+		pnm->buffered += count;
+		row += count;
+		size -= count;
+
+		if (pnm->buffered == BUFFER_SIZE) {
+			pnm->ok = flush(pnm);
+		}
+	}
+
+	stats_end(STATS_ENCODE, begin);
+	stats_count(STATS_ROWS, 1);
+
+	return pnm->ok;
+}
+
+bool pnm_close(struct PnmWriter* pnm) {
+	uint64_t begin = stats_clock();
+	bool ok = pnm->ok && pnm->rows_written == pnm->height && flush(pnm);
+
+	if (!pnm->is_stdout && close(pnm->fd) != 0) {
+		ok = false;
+	}
+
+	free(pnm->buffer);
+	free(pnm);
+	stats_end(STATS_ENCODE, begin);
+
+	return ok;
+}
@@ -0,0 +1,49 @@
+#ifndef PNM_H
+#define PNM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * A binary PBM or PPM writer which takes one row at a time. Nothing is
+ * compressed, rows are copied into a large buffer which is written out with
+ * `write` whenever it fills, and rows larger than the buffer are written
+ * straight from the caller, so images of any height stream at the speed of
+ * the pipe or disk they are written to.
+ */
+
+enum PnmKind {
+	PNM_BITMAP = 4, /* P4, 1 bit per pixel */
+	PNM_PIXMAP = 6  /* P6, 3 bytes per pixel */
+};
+
+struct PnmWriter;
+
+/**
+ * Creates `filename`, or uses stdout if it is "-", and writes the header.
+ *
+ * - returns NULL on failure.
+ */
+struct PnmWriter* pnm_open(
+	const char* filename, size_t width, size_t height, enum PnmKind kind
+);
+
+/**
+ * Writes the next row, rows are given from top to bottom.
+ *
+ * - bitmap rows are in the mono format of `palette.h`, where a set bit is
+ *   white, and are inverted as PBM has set bits black.
+ * - pixmap rows are RGB.
+ */
+bool pnm_write_row(struct PnmWriter* pnm, const uint8_t* row);
+
+/**
+ * Writes out what is buffered and closes the file.
+ *
+ * - fails if fewer rows were written than the height of the image.
+ * - the writer is freed either way.
+ */
+bool pnm_close(struct PnmWriter* pnm);
+
+#endif /* PNM_H */
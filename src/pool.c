@@ -0,0 +1,205 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "pool.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/*
+ * Jobs follow one another quickly, a generation of a wide row takes tens of
+ * microseconds, so idle workers spin for a while before going to sleep.
+ */
+#define SPIN_LIMIT 20000
+
+struct Pool {
+	int worker_count;
+	pthread_t* workers;
+
+	pthread_mutex_t lock;
+	pthread_cond_t wake;   /* a job was submitted */
+	pthread_cond_t done;   /* every worker has left the job */
+
+	/* the current job, only changed while no worker is running it */
+	pool_task_fn* task_fn;
+	void* context;
+	size_t task_count;
+
+	/* shared between threads, accessed atomically */
+	unsigned long epoch;   /* incremented for each job */
+	size_t next_task;
+	int departed;          /* workers finished with the current job */
+	bool stop;
+};
+
+static void relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#endif
+}
+
+/* takes tasks until none remain */
+static void run_tasks(struct Pool* pool) {
+	for (;;) {
+		size_t index = __atomic_fetch_add(
+			&pool->next_task, 1, __ATOMIC_RELAXED
+		);
+		if (index >= pool->task_count) {
+			break;
+		}
+
+		pool->task_fn(pool->context, index);
+	}
+}
+
+/* waits for the epoch to move on from `seen`, returning the new epoch */
+static unsigned long wait_for_job(struct Pool* pool, unsigned long seen) {
+	unsigned long epoch = seen;
+
+	for (int spin = 0; spin < SPIN_LIMIT; ++spin) {
+		epoch = __atomic_load_n(&pool->epoch, __ATOMIC_ACQUIRE);
+		if (epoch != seen) {
+			return epoch;
+		}
+		relax();
+	}
+
+	pthread_mutex_lock(&pool->lock);
+	for (;;) {
+		epoch = __atomic_load_n(&pool->epoch, __ATOMIC_ACQUIRE);
+		if (epoch != seen) {
+			break;
+		}
+		pthread_cond_wait(&pool->wake, &pool->lock);
+	}
+	pthread_mutex_unlock(&pool->lock);
+
+	return epoch;
+}
+
+static void* worker_main(void* arg) {
+	struct Pool* pool = arg;
+	unsigned long seen = 0;
+
+	for (;;) {
+		seen = wait_for_job(pool, seen);
+		if (__atomic_load_n(&pool->stop, __ATOMIC_ACQUIRE)) {
+			break;
+		}
+
+		run_tasks(pool);
+
+		/* the last worker out wakes the submitter */
+		int departed = __atomic_add_fetch(
+			&pool->departed, 1, __ATOMIC_ACQ_REL
+		);
+		if (departed == pool->worker_count) {
+			pthread_mutex_lock(&pool->lock);
+			pthread_cond_broadcast(&pool->done);
+			pthread_mutex_unlock(&pool->lock);
+		}
+	}
+
+	return NULL;
+}
+
+/* publishes the current job to the workers */
+static void start_job(struct Pool* pool) {
+	__atomic_store_n(&pool->next_task, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&pool->departed, 0, __ATOMIC_RELAXED);
+
+	pthread_mutex_lock(&pool->lock);
+	__atomic_add_fetch(&pool->epoch, 1, __ATOMIC_RELEASE);
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+/* waits for every worker to leave the current job */
+static void finish_job(struct Pool* pool) {
+	for (int spin = 0; spin < SPIN_LIMIT; ++spin) {
+		int departed = __atomic_load_n(&pool->departed, __ATOMIC_ACQUIRE);
+		if (departed == pool->worker_count) {
+			return;
+		}
+		relax();
+	}
+
+	pthread_mutex_lock(&pool->lock);
+	while (
+		__atomic_load_n(&pool->departed, __ATOMIC_ACQUIRE)
+		!= pool->worker_count
+	) {
+		pthread_cond_wait(&pool->done, &pool->lock);
+	}
+	pthread_mutex_unlock(&pool->lock);
+}
+
+struct Pool* pool_create(int thread_count) {
+	struct Pool* pool = calloc(1, sizeof(*pool));
+	if (pool == NULL) {
+		return NULL;
+	}
+
+	pool->worker_count = (thread_count > 1) ? thread_count - 1 : 0;
+	pool->workers = calloc(pool->worker_count + 1, sizeof(*pool->workers));
+	if (pool->workers == NULL) {
+		free(pool);
+		return NULL;
+	}
+
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->wake, NULL);
+	pthread_cond_init(&pool->done, NULL);
+
+	for (int i = 0; i < pool->worker_count; ++i) {
+		pthread_t* worker = &pool->workers[i];
+		if (pthread_create(worker, NULL, worker_main, pool) != 0) {
+			/* keep the workers which did start */
+			pool->worker_count = i;
+			break;
+		}
+	}
+
+	return pool;
+}
+
+void pool_run(
+	struct Pool* pool, pool_task_fn* task_fn, void* context, size_t task_count
+) {
+	pool->task_fn = task_fn;
+	pool->context = context;
+	pool->task_count = task_count;
+
+	if (pool->worker_count == 0 || task_count == 1) {
+		for (size_t i = 0; i < task_count; ++i) {
+			task_fn(context, i);
+		}
+		return;
+	}
+
+	start_job(pool);
+	run_tasks(pool);
+	finish_job(pool);
+}
+
+void pool_destroy(struct Pool* pool) {
+	__atomic_store_n(&pool->stop, true, __ATOMIC_RELEASE);
+	start_job(pool);
+
+	for (int i = 0; i < pool->worker_count; ++i) {
+		pthread_join(pool->workers[i], NULL);
+	}
+
+	pthread_cond_destroy(&pool->done);
+	pthread_cond_destroy(&pool->wake);
+	pthread_mutex_destroy(&pool->lock);
+
+	free(pool->workers);
+	free(pool);
+}
+
+int pool_processor_count(void) {
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return (count < 1) ? 1 : (int)count;
+}
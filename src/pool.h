@@ -0,0 +1,44 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+
+/*
+ * A fixed set of worker threads, created once and reused for every job.
+ *
+ * A job is split into numbered tasks which the workers, and the thread that
+ * submitted the job, take in turn until none remain. Submitting waits until
+ * every worker has finished with the job, so consecutive jobs are separated
+ * by a barrier.
+ */
+
+struct Pool;
+
+/* runs task `index` of a job */
+typedef void pool_task_fn(void* context, size_t index);
+
+/**
+ * Starts `thread_count - 1` workers, the caller of `pool_run` is the last.
+ *
+ * - returns NULL on failure.
+ */
+struct Pool* pool_create(int thread_count);
+
+/**
+ * Runs tasks `[0, task_count)` of `task_fn` and waits for them to finish.
+ */
+void pool_run(
+	struct Pool* pool, pool_task_fn* task_fn, void* context, size_t task_count
+);
+
+/**
+ * Stops and joins every worker.
+ */
+void pool_destroy(struct Pool* pool);
+
+/**
+ * The number of processors online, at least 1.
+ */
+int pool_processor_count(void);
+
+#endif /* POOL_H */
@@ -0,0 +1,1150 @@
+#include "render.h"
+
+#include "analysis.h"
+#include "checkpoint.h"
+#include "cycle.h"
+#include "eca.h"
+#include "hashlife.h"
+#include "initial.h"
+#include "lut.h"
+#include "packed.h"
+#include "png.h"
+#include "pnm.h"
+#include "pool.h"
+#include "rng.h"
+#include "simd.h"
+#include "stats.h"
+#include "symmetry.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const int channel_count = 3;
+
+/*
+ * Wide packed rows are split into chunks of this many words, each generated
+ * and coloured by one thread. 2048 words is 16 KiB per plane, so a chunk of
+ * both generations stays in cache while it is coloured.
+ */
+static const size_t chunk_words = 2048;
+
+/* coloured rows of a cycle are kept for reuse up to this many bytes */
+static const size_t tile_limit = 64 << 20;
+
+void render_palette(struct Palette* palette, enum Mode mode) {
+	/* standard display draws black pixels on a white background */
+	switch (mode) {
+		default:
+		case MODE_STANDARD:    palette_standard(palette);    break;
+		case MODE_SPLIT:       palette_split(palette);       break;
+		case MODE_DIRECTIONAL: palette_directional(palette); break;
+	}
+}
+
+/* the time spent populating the first generation is added to `initialise` */
+typedef bool render_fn(
+	const struct Options* options, const struct Palette* palette,
+	enum Format format, render_row_fn* row_fn, void* context,
+	uint64_t* initialise
+);
+
+static bool render_bytes(
+	const struct Options* options, const struct Palette* palette,
+	enum Format format, render_row_fn* row_fn, void* context,
+	uint64_t* initialise
+) {
+	size_t width = options->width;
+	uint8_t rules[3];
+	memcpy(rules, options->rules, sizeof(rules));
+
+	eca_gen_fn* gen_fn = NULL;
+	if (options->engine == ENGINE_LUT) {
+		switch (options->mode) {
+			default:
+			case MODE_STANDARD:
+				gen_fn = eca_generate_lut;
+				break;
+			case MODE_SPLIT:
+				gen_fn = eca_generate_split_lut;
+				break;
+			case MODE_DIRECTIONAL:
+				gen_fn = eca_generate_directional_lut;
+				break;
+		}
+
+		eca_lut_prepare(rules, channel_count);
+	} else {
+		switch (options->mode) {
+			default:
+			case MODE_STANDARD:
+				gen_fn = eca_generate;
+				break;
+			case MODE_SPLIT:
+				gen_fn = eca_generate_split;
+				break;
+			case MODE_DIRECTIONAL:
+				gen_fn = eca_generate_directional;
+				break;
+		}
+
+		/*
+		 * use a vectorised kernel where the cpu supports one, otherwise
+		 * a standard kernel specialised for the rule
+		 */
+		eca_gen_fn* simd_fn = eca_simd_select(gen_fn);
+		if (simd_fn != gen_fn) {
+			gen_fn = simd_fn;
+		} else if (options->mode == MODE_STANDARD) {
+			gen_fn = eca_rule_kernel(rules[0]);
+		}
+	}
+
+	/* two generations of cell states, and the coloured row */
+	size_t row_size = width * channel_count;
+	uint8_t* current = malloc(row_size);
+	uint8_t* next = malloc(row_size);
+	uint8_t* pixels = malloc(palette_row_size(format, width));
+
+	bool ok = current != NULL && next != NULL && pixels != NULL;
+	if (ok) {
+		uint64_t begin = stats_clock();
+		memset(current, ECA_OFF, row_size);
+		ok = initial_bytes(options, current, channel_count);
+		*initialise += stats_clock() - begin;
+	}
+
+	for (size_t i = 0; ok && i < options->height; ++i) {
+		uint64_t steps = (i == 0) ? options->start : options->stride;
+		for (uint64_t k = 0; k < steps; ++k) {
+			/* generators only write activated cells */
+			memset(next, ECA_OFF, row_size);
+			gen_fn(next, current, width, channel_count, rules);
+
+			uint8_t* tmp = current;
+			current = next;
+			next = tmp;
+		}
+
+		palette_apply_bytes(
+			palette, format, pixels, current, width, channel_count
+		);
+		ok = row_fn(context, pixels, i);
+	}
+
+	free(pixels);
+	free(next);
+	free(current);
+
+	return ok;
+}
+
+static eca_packed_range_fn* packed_range_fn(enum Mode mode) {
+	switch (mode) {
+		default:
+		case MODE_STANDARD:
+			return eca_packed_generate_range;
+		case MODE_SPLIT:
+			return eca_packed_generate_split_range;
+		case MODE_DIRECTIONAL:
+			return eca_packed_generate_directional_range;
+	}
+}
+
+/*
+ * The cells of a row which differ from the background, see `packed.h`. Only
+ * the words around them are generated, the rest are set to the background.
+ * Tracking stops once the cells reach the edges of the row, where they wrap.
+ */
+struct Cone {
+	bool tracking;
+	bool empty;                                 /* no cell differs */
+	size_t first;
+	size_t last;
+	uint64_t background[ECA_PLANES_DIRECTIONAL];
+
+	/* the words being generated, and the background around them */
+	size_t begin;
+	size_t end;
+	uint64_t next[ECA_PLANES_DIRECTIONAL];
+};
+
+/* one generation of a packed row, split into chunks */
+struct PackedJob {
+	const struct Palette* palette;
+	enum Format format;
+	eca_packed_range_fn* gen_fn;
+	uint8_t rules[3];
+
+	size_t width;
+	size_t words;
+	uint64_t* dst;
+	const uint64_t* src; /* NULL to only colour `dst` */
+	uint8_t* pixels;     /* NULL to only generate */
+	uint64_t* hashes;    /* hash of each chunk of `dst`, NULL to skip */
+	struct Cone* cone;   /* NULL to generate every word */
+};
+
+static void packed_chunk(void* context, size_t index) {
+	struct PackedJob* job = context;
+	int plane_count = job->palette->plane_count;
+
+	size_t begin = index * chunk_words;
+	size_t end = begin + chunk_words;
+	if (end > job->words) {
+		end = job->words;
+	}
+
+	const struct Cone* cone = job->cone;
+	if (job->src != NULL && cone != NULL && cone->tracking) {
+		size_t from = (cone->begin > begin) ? cone->begin : begin;
+		size_t to = (cone->end < end) ? cone->end : end;
+		if (from >= to) {
+			from = to = end;
+		}
+
+		/* the kernels always finish the last word of the row */
+		eca_packed_fill(
+			job->dst, job->width, plane_count, cone->next, begin, from
+		);
+		if (from < to) {
+			job->gen_fn(
+				job->dst, job->src, job->width, plane_count, job->rules,
+				from, to
+			);
+		}
+		eca_packed_fill(
+			job->dst, job->width, plane_count, cone->next, to, end
+		);
+	} else if (job->src != NULL) {
+		job->gen_fn(
+			job->dst, job->src, job->width, plane_count, job->rules,
+			begin, end
+		);
+	}
+
+	if (job->hashes != NULL) {
+		uint64_t hash = index;
+		for (int plane = 0; plane < plane_count; ++plane) {
+			const uint64_t* words = job->dst + (plane * job->words);
+			hash = cycle_hash(words + begin, end - begin, hash);
+		}
+		job->hashes[index] = hash;
+	}
+
+	if (job->pixels == NULL) {
+		return;
+	}
+
+	size_t last_cell = end * 64;
+	if (last_cell > job->width) {
+		last_cell = job->width;
+	}
+
+	palette_apply_range(
+		job->palette, job->format, job->pixels, job->dst, job->width,
+		begin * 64, last_cell
+	);
+}
+
+/* starts following the cells of `src` which differ from a clear row */
+static void cone_init(
+	struct Cone* cone, const struct PackedJob* job, const uint64_t* src
+) {
+	int plane_count = job->palette->plane_count;
+	memset(cone, 0, sizeof(*cone));
+
+	cone->tracking = true;
+	cone->empty = !eca_packed_span(
+		src, job->width, plane_count, cone->background, 0, job->words,
+		&cone->first, &cone->last
+	);
+}
+
+/* chooses the words of the next generation which may leave the background */
+static void cone_grow(struct Cone* cone, struct PackedJob* job) {
+	int plane_count = job->palette->plane_count;
+
+	eca_packed_background(
+		cone->next, cone->background, plane_count, job->rules, job->gen_fn
+	);
+
+	if (cone->empty) {
+		cone->begin = cone->end = 0;
+	} else if (cone->first == 0 || cone->last + 1 == job->width) {
+		cone->tracking = false;
+	} else {
+		cone->begin = (cone->first - 1) / 64;
+		cone->end = ((cone->last + 1) / 64) + 1;
+	}
+}
+
+/* finds the cells of the new generation `dst` which left the background */
+static void cone_update(
+	struct Cone* cone, const struct PackedJob* job, const uint64_t* dst
+) {
+	int plane_count = job->palette->plane_count;
+
+	memcpy(cone->background, cone->next, sizeof(cone->background));
+	cone->empty = !eca_packed_span(
+		dst, job->width, plane_count, cone->background,
+		cone->begin, cone->end, &cone->first, &cone->last
+	);
+}
+
+/* generates `dst` from `src`, or only colours `dst` if `src` is NULL */
+static void packed_step(
+	struct Pool* pool, struct PackedJob* job, size_t chunk_count,
+	uint64_t* dst, const uint64_t* src, uint8_t* pixels
+) {
+	struct Cone* cone = job->cone;
+	bool tracking = src != NULL && cone != NULL && cone->tracking;
+	if (tracking) {
+		cone_grow(cone, job);
+	}
+
+	job->dst = dst;
+	job->src = src;
+	job->pixels = pixels;
+	pool_run(pool, packed_chunk, job, chunk_count);
+
+	if (tracking && cone->tracking) {
+		cone_update(cone, job, dst);
+	}
+}
+
+static uint64_t row_hash(const struct PackedJob* job, size_t chunk_count) {
+	if (chunk_count == 1) {
+		return job->hashes[0];
+	}
+
+	return cycle_hash(job->hashes, chunk_count, 0);
+}
+
+static uint64_t gcd(uint64_t a, uint64_t b) {
+	while (b != 0) {
+		uint64_t t = a % b;
+		a = b;
+		b = t;
+	}
+
+	return a;
+}
+
+/*
+ * The number of generations before the cycle: a second row started `period`
+ * generations ahead first meets the first row at the start of the cycle.
+ *
+ * Rows start from `first`, the row resumed from or the initial row.
+ */
+static bool packed_transient(
+	struct Pool* pool, struct PackedJob* job, size_t chunk_count,
+	const uint64_t* first, int plane_count,
+	uint64_t period, uint64_t* transient
+) {
+	/* the cone follows the rows being shown, not these */
+	struct Cone* cone = job->cone;
+	job->cone = NULL;
+
+	size_t size = job->words * plane_count * sizeof(uint64_t);
+	uint64_t* slow = malloc(size);
+	uint64_t* fast = malloc(size);
+	uint64_t* slow_next = malloc(size);
+	uint64_t* fast_next = malloc(size);
+
+	bool ok = slow != NULL && fast != NULL && slow_next != NULL
+	       && fast_next != NULL;
+
+	if (ok) {
+		memcpy(slow, first, size);
+		memcpy(fast, first, size);
+	}
+
+	if (ok) {
+		for (uint64_t k = 0; k < period; ++k) {
+			packed_step(pool, job, chunk_count, fast_next, fast, NULL);
+			uint64_t* tmp = fast;
+			fast = fast_next;
+			fast_next = tmp;
+		}
+
+		*transient = 0;
+		while (memcmp(slow, fast, size) != 0) {
+			packed_step(pool, job, chunk_count, slow_next, slow, NULL);
+			packed_step(pool, job, chunk_count, fast_next, fast, NULL);
+
+			uint64_t* tmp = slow;
+			slow = slow_next;
+			slow_next = tmp;
+			tmp = fast;
+			fast = fast_next;
+			fast_next = tmp;
+
+			*transient += 1;
+		}
+	}
+
+	free(fast_next);
+	free(slow_next);
+	free(fast);
+	free(slow);
+
+	job->cone = cone;
+
+	return ok;
+}
+
+/*
+ * A run resumed inside the cycle only knows that the cycle started by the
+ * checkpoint, so its transient is printed as `at_most` the generation.
+ */
+/*
+ * Saves a checkpoint of `row` if one is due, or asked for by a signal.
+ *
+ * - returns false if the checkpoint could not be written.
+ */
+static bool packed_checkpoint(
+	const struct Options* options, int plane_count, const uint64_t* row,
+	uint64_t generation, bool last
+) {
+	const char* filename = options->checkpoint_file;
+	uint64_t interval = options->checkpoint_interval;
+
+	bool due = last || (interval != 0 && generation % interval == 0);
+	if (filename == NULL || !(checkpoint_requested() || due)) {
+		return true;
+	}
+
+	if (!checkpoint_write(filename, options, plane_count, row, generation)) {
+		fprintf(stderr, "error: could not write checkpoint %s\n", filename);
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * The planes which may jump ahead, see `eca_packed_jump`, 0 if the rules are
+ * not linear. Only the state plane of directional mode jumps, the parents are
+ * found again by the generation which follows.
+ */
+static int packed_jump_planes(const struct Options* options) {
+	const uint8_t* rules = options->rules;
+
+	switch (options->mode) {
+		case MODE_STANDARD:
+		case MODE_DIRECTIONAL: {
+			return eca_packed_linear(rules[0]) ? 1 : 0;
+		}
+		case MODE_SPLIT: {
+			bool linear = eca_packed_linear(rules[0])
+			           && eca_packed_linear(rules[1])
+			           && eca_packed_linear(rules[2]);
+			return linear ? ECA_PLANES_SPLIT : 0;
+		}
+		default: {
+			return 0;
+		}
+	}
+}
+
+static bool render_packed(
+	const struct Options* options, const struct Palette* palette,
+	enum Format format, render_row_fn* row_fn, void* context,
+	uint64_t* initialise
+) {
+	struct PackedJob job = {
+		.palette = palette,
+		.format = format,
+		.gen_fn = packed_range_fn(options->mode),
+		.width = options->width,
+		.words = eca_packed_words(options->width)
+	};
+	memcpy(job.rules, options->rules, sizeof(job.rules));
+
+	int plane_count = palette->plane_count;
+	size_t chunk_count = (job.words + chunk_words - 1) / chunk_words;
+
+	/* rows narrower than a chunk are not worth waking the workers for */
+	int thread_count = options->threads;
+	if ((size_t)thread_count > chunk_count) {
+		thread_count = chunk_count;
+	}
+
+	/* only two generations are kept, pixels are coloured row by row */
+	size_t packed_size = job.words * plane_count;
+	size_t row_size = palette_row_size(format, job.width);
+	uint64_t* current = malloc(packed_size * sizeof(*current));
+	uint64_t* next = malloc(packed_size * sizeof(*next));
+	uint8_t* pixels = malloc(row_size);
+	struct Pool* pool = pool_create(thread_count);
+
+	/* every generation is checked for a repeat until one is found */
+	struct Cycle cycle;
+	bool cycle_ok = cycle_init(&cycle, packed_size);
+	struct Cone cone;
+	job.hashes = malloc(chunk_count * sizeof(*job.hashes));
+
+	bool ok = current != NULL && next != NULL && pixels != NULL
+	       && pool != NULL && cycle_ok && job.hashes != NULL;
+
+	/* a resumed run starts from the row of its checkpoint */
+	struct Checkpoint resume = {0};
+	if (ok && options->resume_file != NULL) {
+		ok = checkpoint_open(&resume, options->resume_file)
+		  && resume.header->width == job.width
+		  && resume.header->plane_count == (uint32_t)plane_count;
+	}
+
+	/* otherwise from the initial row, kept for finding the transient */
+	uint64_t* initial = NULL;
+	if (ok && resume.row == NULL) {
+		uint64_t begin = stats_clock();
+		initial = malloc(packed_size * sizeof(*initial));
+		ok = initial != NULL && initial_packed(options, initial, plane_count);
+		*initialise += stats_clock() - begin;
+	}
+	const uint64_t* first = (resume.row != NULL) ? resume.row : initial;
+
+	uint64_t generation = 0;
+	bool started = ok;
+	if (ok) {
+		uint64_t begin = stats_clock();
+		memcpy(current, first, packed_size * sizeof(*current));
+		if (resume.row != NULL) {
+			generation = resume.header->generation;
+		}
+		packed_step(pool, &job, chunk_count, current, NULL, NULL);
+		cone_init(&cone, &job, current);
+		job.cone = &cone;
+		*initialise += stats_clock() - begin;
+		cycle_check(&cycle, current, row_hash(&job, chunk_count), 0);
+	}
+
+	/* cycles are checked from the first generation */
+	uint64_t first_generation = generation;
+
+	/* linear rules skip to the generation before each row shown */
+	int jump_planes = packed_jump_planes(options);
+	bool jumped = false;
+
+	/* once the cycle is found, shown rows repeat every `tile_count` */
+	uint8_t* tiles = NULL;
+	size_t tile_count = 0;
+	size_t tile_first = 0;
+	size_t tiles_filled = 0;
+
+	/* a signal to stop leaves the rest of the rows for a later run */
+	for (size_t i = 0; ok && i < options->height; ++i) {
+		if (checkpoint_stopping()) {
+			break;
+		}
+
+		uint64_t target = options->start + (i * options->stride);
+
+		size_t tile = (tiles != NULL) ? (i - tile_first) % tile_count : 0;
+		if (tiles != NULL && tile < tiles_filled) {
+			ok = row_fn(context, tiles + (tile * row_size), i);
+			continue;
+		}
+
+		/* only the position within the cycle matters */
+		if (cycle.period != 0) {
+			generation = target - ((target - generation) % cycle.period);
+		}
+
+		/* the last generation of a stride is coloured as it is made */
+		bool coloured = false;
+		while (ok && generation < target && !checkpoint_stopping()) {
+			uint64_t skip = target - 1 - generation;
+			if (jump_planes > 0 && cycle.period == 0
+			 && skip >= ECA_JUMP_STEPS) {
+				eca_packed_jump(
+					current, next, job.width, jump_planes, job.rules, skip
+				);
+				generation += skip;
+				jumped = true;
+				cone.tracking = false;
+			}
+
+			uint8_t* shown = (generation + 1 == target) ? pixels : NULL;
+			packed_step(pool, &job, chunk_count, next, current, shown);
+			coloured = shown != NULL;
+
+			uint64_t* tmp = current;
+			current = next;
+			next = tmp;
+			generation += 1;
+
+			ok = packed_checkpoint(
+				options, plane_count, current, generation, false
+			);
+
+			if (
+				!ok || cycle.period != 0 || jumped
+				|| !cycle_check(
+					&cycle, current, row_hash(&job, chunk_count),
+					generation - first_generation
+				)
+			) {
+				continue;
+			}
+
+			free(job.hashes);
+			job.hashes = NULL;
+
+			uint64_t transient = 0;
+			ok = packed_transient(
+				pool, &job, chunk_count, first, plane_count,
+				cycle.period, &transient
+			);
+
+			/* a transient of the first generation shown only bounds it */
+			stats_count(STATS_CYCLES, 1);
+			stats_max(STATS_TRANSIENT, first_generation + transient);
+			stats_max(STATS_PERIOD, cycle.period);
+
+			/* rows are only kept if a whole cycle of them fits */
+			tile_count = cycle.period / gcd(cycle.period, options->stride);
+			tile_first = i;
+			if (tile_count <= tile_limit / row_size) {
+				tiles = malloc(tile_count * row_size);
+			}
+
+			generation = target - ((target - generation) % cycle.period);
+		}
+
+		/* stopped short of the row, which is left for a later run */
+		if (generation < target) {
+			break;
+		}
+
+		if (ok && !coloured) {
+			packed_step(pool, &job, chunk_count, current, NULL, pixels);
+		}
+
+		if (tiles != NULL) {
+			memcpy(tiles + (tile * row_size), pixels, row_size);
+			tiles_filled += 1;
+		}
+
+		ok = ok && row_fn(context, pixels, i);
+	}
+
+	/* rows copied from the cycle leave `current` behind the last row shown */
+	uint64_t last = options->start + ((options->height - 1) * options->stride);
+	bool behind = cycle.period != 0 && generation < last;
+	if (ok && behind && !checkpoint_stopping()) {
+		uint64_t steps = (last - generation) % cycle.period;
+		for (uint64_t k = 0; k < steps; ++k) {
+			packed_step(pool, &job, chunk_count, next, current, NULL);
+			uint64_t* tmp = current;
+			current = next;
+			next = tmp;
+		}
+		generation = last;
+	}
+
+	/* the run can be carried on from where it ended */
+	if (started) {
+		ok = packed_checkpoint(
+			options, plane_count, current, generation, true
+		) && ok;
+	}
+	if (ok && started && checkpoint_stopping()) {
+		fprintf(
+			stderr, "stopped: generation %llu saved to %s\n",
+			(unsigned long long)generation, options->checkpoint_file
+		);
+		checkpoint_set_stopped();
+	}
+
+	if (pool != NULL) {
+		pool_destroy(pool);
+	}
+	checkpoint_close(&resume);
+	free(initial);
+	free(tiles);
+	free(job.hashes);
+	cycle_free(&cycle);
+	free(pixels);
+	free(next);
+	free(current);
+
+	return ok;
+}
+
+/* one band of generations of a packed row, split into tiles */
+struct TileJob {
+	eca_packed_range_fn* gen_fn;
+	uint8_t rules[3];
+	int plane_count;
+
+	size_t width;
+	size_t words;
+	const uint64_t* src;
+	uint64_t* dst[ECA_TILE_STEPS];
+	int steps;
+};
+
+static void tile_task(void* context, size_t index) {
+	struct TileJob* job = context;
+
+	size_t begin = index * ECA_TILE_WORDS;
+	size_t end = begin + ECA_TILE_WORDS;
+	if (end > job->words) {
+		end = job->words;
+	}
+
+	eca_packed_advance_tile(
+		job->dst, job->src, job->width, job->plane_count, job->rules,
+		job->gen_fn, begin, end, job->steps
+	);
+}
+
+static bool render_tiled(
+	const struct Options* options, const struct Palette* palette,
+	enum Format format, render_row_fn* row_fn, void* context,
+	uint64_t* initialise
+) {
+	size_t width = options->width;
+	size_t words = eca_packed_words(width);
+	int plane_count = palette->plane_count;
+
+	struct TileJob tiles = {
+		.gen_fn = packed_range_fn(options->mode),
+		.plane_count = plane_count,
+		.width = width,
+		.words = words
+	};
+	memcpy(tiles.rules, options->rules, sizeof(tiles.rules));
+
+	struct PackedJob colour = {
+		.palette = palette,
+		.format = format,
+		.width = width,
+		.words = words
+	};
+
+	size_t tile_count = (words + ECA_TILE_WORDS - 1) / ECA_TILE_WORDS;
+	size_t chunk_count = (words + chunk_words - 1) / chunk_words;
+
+	int thread_count = options->threads;
+	if ((size_t)thread_count > tile_count) {
+		thread_count = tile_count;
+	}
+
+	/*
+	 * each band advances the first row by up to ECA_TILE_STEPS
+	 * generations into the last row, only the generations which are
+	 * shown are stored in between
+	 */
+	size_t stride = options->stride;
+	size_t kept_count = (ECA_TILE_STEPS + stride - 1) / stride;
+	size_t packed_size = words * plane_count;
+
+	uint64_t* first = malloc(packed_size * sizeof(*first));
+	uint64_t* last = malloc(packed_size * sizeof(*last));
+	uint64_t* kept = malloc(kept_count * packed_size * sizeof(*kept));
+	uint8_t* pixels = malloc(palette_row_size(format, width));
+	struct Pool* pool = pool_create(thread_count);
+
+	bool ok = first != NULL && last != NULL && kept != NULL
+	       && pixels != NULL && pool != NULL;
+
+	uint64_t start = options->start;
+	size_t index = 0;
+
+	if (ok) {
+		uint64_t begin = stats_clock();
+		ok = initial_packed(options, first, plane_count);
+		*initialise += stats_clock() - begin;
+		colour.pixels = pixels;
+
+		if (ok && start == 0) {
+			colour.dst = first;
+			pool_run(pool, packed_chunk, &colour, chunk_count);
+			ok = row_fn(context, pixels, index++);
+		}
+	}
+
+	uint64_t generation = 0;
+	uint64_t generation_count = start + ((options->height - 1) * stride);
+
+	while (ok && generation < generation_count) {
+		uint64_t remaining = generation_count - generation;
+		int steps = (remaining < ECA_TILE_STEPS) ? remaining
+		                                         : ECA_TILE_STEPS;
+
+		uint64_t* shown[ECA_TILE_STEPS];
+		int shown_count = 0;
+		size_t kept_used = 0;
+
+		for (int t = 1; t <= steps; ++t) {
+			uint64_t g = generation + t;
+			bool show = g >= start && (g - start) % stride == 0;
+			uint64_t* row = NULL;
+
+			if (t == steps) {
+				row = last;
+			} else if (show) {
+				row = kept + (kept_used * packed_size);
+				kept_used += 1;
+			}
+
+			tiles.dst[t - 1] = row;
+			if (show) {
+				shown[shown_count++] = row;
+			}
+		}
+
+		tiles.src = first;
+		tiles.steps = steps;
+		pool_run(pool, tile_task, &tiles, tile_count);
+
+		for (int n = 0; ok && n < shown_count; ++n) {
+			colour.dst = shown[n];
+			pool_run(pool, packed_chunk, &colour, chunk_count);
+			ok = row_fn(context, pixels, index++);
+		}
+
+		uint64_t* tmp = first;
+		first = last;
+		last = tmp;
+
+		generation += steps;
+	}
+
+	if (pool != NULL) {
+		pool_destroy(pool);
+	}
+	free(pixels);
+	free(kept);
+	free(last);
+	free(first);
+
+	return ok;
+}
+
+/* the tables at their end, which are at their largest unless collected */
+static void count_hashlife_stats(const struct HashLife* life) {
+	struct HashLifeStats stats;
+	hashlife_stats(life, &stats);
+
+	stats_max(STATS_HASHLIFE_NODES, stats.nodes);
+	stats_max(STATS_HASHLIFE_MEMO, stats.memo_entries);
+	stats_max(STATS_HASHLIFE_BYTES, stats.memory);
+	stats_count(STATS_HASHLIFE_HITS, stats.hits);
+	stats_count(STATS_HASHLIFE_MISSES, stats.misses);
+	stats_count(STATS_HASHLIFE_COLLECTIONS, stats.collections);
+}
+
+static bool render_hashlife(
+	const struct Options* options, const struct Palette* palette,
+	enum Format format, render_row_fn* row_fn, void* context,
+	uint64_t* initialise
+) {
+	size_t width = options->width;
+	size_t words = eca_packed_words(width);
+	int plane_count = palette->plane_count;
+	size_t packed_size = words * plane_count;
+
+	uint8_t rules[3];
+	memcpy(rules, options->rules, sizeof(rules));
+
+	/*
+	 * split planes each advance with their own rule, directional rows are
+	 * generated from their parent by one packed step, to record the
+	 * parents of each cell
+	 */
+	bool directional = options->mode == MODE_DIRECTIONAL;
+	int life_count = (options->mode == MODE_SPLIT) ? 3 : 1;
+	struct HashLife* lives[3] = {NULL, NULL, NULL};
+
+	uint64_t* current = malloc(packed_size * sizeof(*current));
+	uint64_t* next = malloc(packed_size * sizeof(*next));
+	uint8_t* pixels = malloc(palette_row_size(format, width));
+
+	bool ok = current != NULL && next != NULL && pixels != NULL;
+	for (int n = 0; ok && n < life_count; ++n) {
+		lives[n] = hashlife_create(rules[n], options->memory_limit);
+		ok = lives[n] != NULL;
+	}
+
+	if (ok) {
+		uint64_t begin = stats_clock();
+		ok = initial_packed(options, current, plane_count);
+		*initialise += stats_clock() - begin;
+	}
+
+	uint64_t generation = 0;
+	for (size_t i = 0; ok && i < options->height; ++i) {
+		uint64_t target = options->start + (i * options->stride);
+		const uint64_t* shown = current;
+
+		/* a directional row is kept one generation behind */
+		uint64_t advance_to = (directional && target > 0) ? target - 1
+		                                                  : target;
+		for (int n = 0; ok && n < life_count; ++n) {
+			ok = hashlife_advance(
+				lives[n], current + (n * words), width,
+				advance_to - generation
+			);
+		}
+		generation = advance_to;
+
+		if (ok && directional && target > 0) {
+			eca_packed_generate_directional(
+				next, current, width, plane_count, rules
+			);
+			shown = next;
+		}
+
+		if (ok) {
+			palette_apply(palette, format, pixels, shown, width);
+			ok = row_fn(context, pixels, i);
+		}
+	}
+
+	for (int n = 0; n < life_count; ++n) {
+		if (lives[n] != NULL) {
+			count_hashlife_stats(lives[n]);
+			hashlife_destroy(lives[n]);
+		}
+	}
+	free(pixels);
+	free(next);
+	free(current);
+
+	return ok;
+}
+
+/* times the rows sent out of `render`, so it is left out of generation */
+struct TimedOutput {
+	render_row_fn* row_fn;
+	void* context;
+	uint64_t elapsed;
+	size_t rows;
+};
+
+static bool timed_row(void* context, const uint8_t* row, size_t index) {
+	struct TimedOutput* output = context;
+
+	uint64_t begin = stats_clock();
+	bool ok = output->row_fn(output->context, row, index);
+	output->elapsed += stats_clock() - begin;
+	output->rows += 1;
+
+	return ok;
+}
+
+bool render(
+	const struct Options* options, const struct Palette* palette,
+	enum Format format, render_row_fn* row_fn, void* context
+) {
+	render_fn* fn = NULL;
+	switch (options->engine) {
+		default:
+		case ENGINE_PACKED:   fn = render_packed;   break;
+		case ENGINE_TILED:    fn = render_tiled;    break;
+		case ENGINE_BYTE:     fn = render_bytes;    break;
+		case ENGINE_LUT:      fn = render_bytes;    break;
+		case ENGINE_HASHLIFE: fn = render_hashlife; break;
+	}
+
+	uint64_t initialise = 0;
+	if (!stats_enabled()) {
+		return fn(options, palette, format, row_fn, context, &initialise);
+	}
+
+	struct TimedOutput output = {
+		.row_fn = row_fn, .context = context, .elapsed = 0, .rows = 0
+	};
+
+	uint64_t begin = stats_clock();
+	bool ok = fn(options, palette, format, timed_row, &output, &initialise);
+	uint64_t elapsed = stats_clock() - begin;
+
+	/* generation is reported less the time spent initialising */
+	stats_add(STATS_INITIALISE, initialise);
+	stats_add(STATS_GENERATE, elapsed - output.elapsed - initialise);
+
+	/* the rows sent, as rendering may be stopped early by `row_fn` */
+	if (output.rows > 0) {
+		uint64_t generations = options->start
+		                     + ((output.rows - 1) * options->stride);
+		stats_count(STATS_CELLS, generations * options->width);
+	}
+
+	return ok;
+}
+
+/* an image being written, in whichever output format was chosen */
+struct Image {
+	struct PngWriter* png;
+	struct PnmWriter* pnm;
+	struct AnalysisWriter* analysis;
+	const struct Palette* palette;
+	struct Palette states; /* the palette of an analysis */
+	enum Format format;
+	size_t width;
+	uint8_t* display_buffer;
+};
+
+static bool open_image(
+	struct Image* image, const struct Options* options,
+	const char* filename, const struct Palette* palette
+) {
+	image->png = NULL;
+	image->pnm = NULL;
+	image->analysis = NULL;
+	image->palette = palette;
+	image->width = options->width;
+
+	switch (options->output) {
+		default:
+		case OUTPUT_PNG: {
+			/* indexed by the smallest format holding the palette */
+			image->format = palette_index_format(palette);
+			image->png = png_open(
+				filename, options->width, options->height,
+				PNG_INDEXED, palette_index_bits(image->format),
+				options->compression, options->threads
+			);
+
+			const uint8_t* colours = &palette->colours[0][0];
+			int count = palette->colour_count;
+			if (image->png != NULL
+			 && !png_write_palette(image->png, colours, count)) {
+				png_close(image->png);
+				image->png = NULL;
+			}
+			return image->png != NULL;
+		}
+		case OUTPUT_PBM: {
+			image->format = FORMAT_MONO;
+			image->pnm = pnm_open(
+				filename, options->width, options->height, PNM_BITMAP
+			);
+			return image->pnm != NULL;
+		}
+		case OUTPUT_PPM: {
+			image->format = FORMAT_RGB;
+			image->pnm = pnm_open(
+				filename, options->width, options->height, PNM_PIXMAP
+			);
+			return image->pnm != NULL;
+		}
+		case OUTPUT_CSV:
+		case OUTPUT_BINARY: {
+			/* cells are measured by state rather than colour */
+			palette_states(&image->states, palette->plane_count);
+			image->palette = &image->states;
+			image->format = FORMAT_MONO;
+			image->analysis = analysis_open(
+				filename, options->width, options->height,
+				options->start, options->stride,
+				(options->output == OUTPUT_CSV) ? ANALYSIS_CSV
+				                                : ANALYSIS_BINARY
+			);
+			return image->analysis != NULL;
+		}
+	}
+}
+
+static bool write_row(void* context, const uint8_t* row, size_t index) {
+	struct Image* image = context;
+
+	/* the display is always RGB, however the png is stored */
+	if (image->display_buffer != NULL) {
+		size_t row_size = palette_row_size(FORMAT_RGB, image->width);
+		uint8_t* dst = image->display_buffer + (row_size * index);
+		palette_expand(
+			image->palette, image->format, dst, row, image->width
+		);
+	}
+
+	if (image->png != NULL) {
+		return png_write_row(image->png, row);
+	} else if (image->pnm != NULL) {
+		return pnm_write_row(image->pnm, row);
+	}
+
+	return analysis_write_row(image->analysis, row);
+}
+
+static bool close_image(struct Image* image) {
+	if (image->png != NULL) {
+		return png_close(image->png);
+	} else if (image->pnm != NULL) {
+		return pnm_close(image->pnm);
+	}
+
+	return analysis_close(image->analysis);
+}
+
+bool render_file(
+	const struct Options* options, const char* filename,
+	uint8_t* display_buffer
+) {
+	/* random bits are read from lanes of their own, with nothing drawn */
+	if (options->output == OUTPUT_RNG) {
+		return rng_write(options, filename);
+	}
+
+	struct Palette palette;
+	render_palette(&palette, options->mode);
+
+	struct Image image;
+	if (!open_image(&image, options, filename, &palette)) {
+		return false;
+	}
+	image.display_buffer = display_buffer;
+
+	bool rendered = render(
+		options, image.palette, image.format, write_row, &image
+	);
+	bool saved = close_image(&image);
+
+	/* the rows left for a later run would leave the image short of its size */
+	if (checkpoint_stopped()) {
+		if (strcmp(filename, "-") != 0) {
+			remove(filename);
+		}
+		return false;
+	}
+
+	return rendered && saved;
+}
+
+bool render_file_derived(
+	const struct Options* options, const char* filename,
+	const uint8_t* rows, enum Symmetry symmetry
+) {
+	struct Palette palette;
+	render_palette(&palette, options->mode);
+
+	struct Image image;
+	if (!open_image(&image, options, filename, &palette)) {
+		return false;
+	}
+	image.display_buffer = NULL;
+
+	size_t width = options->width;
+	size_t mono_size = palette_row_size(FORMAT_MONO, width);
+	uint64_t* packed = malloc(eca_packed_words(width) * sizeof(*packed));
+	uint8_t* pixels = malloc(palette_row_size(image.format, width));
+
+	bool ok = packed != NULL && pixels != NULL;
+	for (size_t i = 0; ok && i < options->height; ++i) {
+		symmetry_apply(packed, rows + (i * mono_size), width, symmetry);
+		palette_apply(image.palette, image.format, pixels, packed, width);
+		ok = write_row(&image, pixels, i);
+	}
+
+	ok = close_image(&image) && ok;
+	free(pixels);
+	free(packed);
+
+	return ok;
+}
@@ -0,0 +1,63 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "options.h"
+#include "palette.h"
+#include "symmetry.h"
+
+/*
+ * Rendering runs the chosen engine for `options->height` generations and
+ * hands each one over as a row of pixels, top to bottom. Only the generations
+ * in flight are kept, the caller decides whether rows are stored or streamed.
+ */
+
+/* receives each coloured row, returning false stops rendering */
+typedef bool render_row_fn(void* context, const uint8_t* row, size_t index);
+
+/**
+ * Prepares the palette for a generation mode.
+ */
+void render_palette(struct Palette* palette, enum Mode mode);
+
+/**
+ * Renders every generation, in `format`, to `row_fn`.
+ *
+ * - returns false if memory could not be allocated or `row_fn` failed.
+ */
+bool render(
+	const struct Options* options, const struct Palette* palette,
+	enum Format format, render_row_fn* row_fn, void* context
+);
+
+/**
+ * Renders every generation, streaming rows into the image `filename` in the
+ * output format of `options`, or to stdout if `filename` is "-".
+ *
+ * - PNGs are indexed, in the smallest index format of the palette.
+ * - CSV and binary output are the statistics of each row, see `analysis.h`.
+ * - every row is also copied to `display_buffer` as RGB unless it is NULL,
+ *   which is only supported for PNGs.
+ * - returns false if the image could not be written.
+ */
+bool render_file(
+	const struct Options* options, const char* filename,
+	uint8_t* display_buffer
+);
+
+/**
+ * Saves the image of `options->rules[0]` derived from `rows`, the image of
+ * its canonical rule in the mono format of the standard palette.
+ *
+ * - see `symmetry_canonical`.
+ * - returns false if the image could not be written.
+ */
+bool render_file_derived(
+	const struct Options* options, const char* filename,
+	const uint8_t* rows, enum Symmetry symmetry
+);
+
+#endif /* RENDER_H */
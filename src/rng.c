@@ -0,0 +1,214 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "rng.h"
+
+#include "eca.h"
+#include "rules.h"
+#include "stats.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* generations are gathered until about this many bytes before writing */
+#define BUFFER_SIZE (1024 * 1024)
+
+/*
+ * One generation of every lane for each rule. Rows have a halo word either
+ * side, a copy of the cell at the other end, so the loop has no edges.
+ */
+typedef void lanes_fn(uint64_t* dst, const uint64_t* src, size_t width);
+
+#define LANES_KERNEL(rule, expression) \
+static void generate_lanes_##rule( \
+	uint64_t* dst, const uint64_t* src, size_t width \
+) { \
+	for (size_t j = 1; j <= width; ++j) { \
+		uint64_t l = src[j - 1]; \
+		uint64_t c = src[j]; \
+		uint64_t r = src[j + 1]; \
+		(void)l; (void)c; (void)r; \
+		dst[j] = (expression); \
+	} \
+}
+
+ECA_RULES(LANES_KERNEL)
+
+#undef LANES_KERNEL
+
+#define LANES_ENTRY(rule, expression) generate_lanes_##rule,
+
+static lanes_fn* const lanes_fns[256] = {
+	ECA_RULES(LANES_ENTRY)
+};
+
+#undef LANES_ENTRY
+
+struct RngLanes {
+	size_t width;
+	lanes_fn* gen_fn;
+
+	uint64_t* current;
+	uint64_t* next;
+
+	size_t column_count;
+	size_t columns[]; /* words of the row read, after the halo */
+};
+
+struct RngLanes* rng_lanes_create(
+	size_t width, uint8_t rule, size_t column_count
+) {
+	if (width == 0 || column_count == 0 || column_count > width) {
+		return NULL;
+	}
+
+	struct RngLanes* lanes = malloc(
+		sizeof(*lanes) + (column_count * sizeof(lanes->columns[0]))
+	);
+	if (lanes == NULL) {
+		return NULL;
+	}
+
+	lanes->width = width;
+	lanes->gen_fn = lanes_fns[rule];
+	lanes->current = calloc(width + 2, sizeof(uint64_t));
+	lanes->next = calloc(width + 2, sizeof(uint64_t));
+	lanes->column_count = column_count;
+
+	if (lanes->current == NULL || lanes->next == NULL) {
+		rng_lanes_free(lanes);
+		return NULL;
+	}
+
+	for (size_t k = 0; k < column_count; ++k) {
+		size_t cell = (width / 2) + ((k * width) / column_count);
+		lanes->columns[k] = 1 + (cell % width);
+	}
+
+	/* the same sequence as `eca_packed_initialise_random`, one per lane */
+	for (int lane = 0; lane < RNG_LANES; ++lane) {
+		struct EcaRandom random;
+		eca_random_seed(&random, lane + 1);
+
+		for (size_t j = 1; j <= width; ++j) {
+			uint64_t val = eca_random_next(&random) % 2;
+			lanes->current[j] |= val << lane;
+		}
+	}
+
+	return lanes;
+}
+
+void rng_lanes_free(struct RngLanes* lanes) {
+	if (lanes == NULL) {
+		return;
+	}
+
+	free(lanes->current);
+	free(lanes->next);
+	free(lanes);
+}
+
+static void step(struct RngLanes* lanes) {
+	uint64_t* src = lanes->current;
+	size_t width = lanes->width;
+
+	/* wrap around edges */
+	src[0] = src[width];
+	src[width + 1] = src[1];
+	lanes->gen_fn(lanes->next, src, width);
+
+	lanes->current = lanes->next;
+	lanes->next = src;
+}
+
+void rng_lanes_skip(struct RngLanes* lanes, uint64_t steps) {
+	for (uint64_t k = 0; k < steps; ++k) {
+		step(lanes);
+	}
+}
+
+void rng_lanes_generate(
+	struct RngLanes* lanes, uint64_t* dst, size_t count, uint64_t stride
+) {
+	for (size_t i = 0; i < count; ++i) {
+		for (size_t k = 0; k < lanes->column_count; ++k) {
+			*dst++ = lanes->current[lanes->columns[k]];
+		}
+		rng_lanes_skip(lanes, stride);
+	}
+}
+
+/* writes all of `data`, as `write` may take only part of it */
+static bool write_all(int fd, const void* data, size_t size) {
+	const uint8_t* bytes = data;
+	while (size > 0) {
+		ssize_t count = write(fd, bytes, size);
+		if (count < 0 && errno == EINTR) {
+			continue;
+		}
+		if (count <= 0) {
+			return false;
+		}
+
+		stats_count(STATS_BYTES_WRITTEN, count);
+		bytes += count;
+		size -= count;
+	}
+
+	return true;
+}
+
+bool rng_write(const struct Options* options, const char* filename) {
+	uint64_t begin = stats_clock();
+	struct RngLanes* lanes = rng_lanes_create(
+		options->width, options->rules[0], options->columns
+	);
+	if (lanes != NULL) {
+		rng_lanes_skip(lanes, options->start);
+	}
+	stats_end(STATS_INITIALISE, begin);
+
+	/* a whole number of generations fills the buffer */
+	size_t generation_size = options->columns * sizeof(uint64_t);
+	size_t batch = BUFFER_SIZE / generation_size;
+	if (batch == 0) {
+		batch = 1;
+	}
+	uint64_t* buffer = malloc(batch * generation_size);
+
+	bool is_stdout = strcmp(filename, "-") == 0;
+	int fd = is_stdout ? STDOUT_FILENO : open(
+		filename, O_WRONLY | O_CREAT | O_TRUNC, 0666
+	);
+
+	bool ok = lanes != NULL && buffer != NULL && fd >= 0;
+	for (size_t i = 0; ok && i < options->height; i += batch) {
+		size_t count = options->height - i;
+		if (count > batch) {
+			count = batch;
+		}
+
+		begin = stats_clock();
+		rng_lanes_generate(lanes, buffer, count, options->stride);
+		stats_end(STATS_GENERATE, begin);
+
+		uint64_t generations = count * options->stride;
+		stats_count(STATS_CELLS, generations * options->width * RNG_LANES);
+
+		begin = stats_clock();
+		ok = write_all(fd, buffer, count * generation_size);
+		stats_end(STATS_ENCODE, begin);
+	}
+
+	if (fd >= 0 && !is_stdout && close(fd) != 0) {
+		ok = false;
+	}
+
+	free(buffer);
+	rng_lanes_free(lanes);
+
+	return ok;
+}
@@ -0,0 +1,60 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "options.h"
+
+/*
+ * Random bits from the columns of a rule, usually rule 30, read generation by
+ * generation without drawing anything.
+ *
+ * The lanes are 64 automata of the same width run side by side, bit-sliced:
+ * cell `j` of lane `l` is bit `l` of word `j`, so one word of every cell is a
+ * generation of all 64 lanes, and each column gives 64 bits a generation.
+ * Lane `l` starts from the random row of `eca_random_seed(l + 1)`, so lane 0
+ * is the row of `-i random`, and every lane is independent of the others.
+ */
+
+#define RNG_LANES 64
+
+struct RngLanes;
+
+/**
+ * Seeds the lanes of `width` cells, read at `column_count` columns spaced
+ * evenly around the row, starting from the centre.
+ *
+ * - returns NULL on failure.
+ */
+struct RngLanes* rng_lanes_create(
+	size_t width, uint8_t rule, size_t column_count
+);
+
+void rng_lanes_free(struct RngLanes* lanes);
+
+/**
+ * Advances every lane by `steps` generations without reading them.
+ */
+void rng_lanes_skip(struct RngLanes* lanes, uint64_t steps);
+
+/**
+ * Reads the columns of the current generation and advances by `stride`
+ * generations, `count` times.
+ *
+ * - `dst` is `count * column_count` words, a word of 64 lanes per column.
+ */
+void rng_lanes_generate(
+	struct RngLanes* lanes, uint64_t* dst, size_t count, uint64_t stride
+);
+
+/**
+ * Writes `options->height` generations of random bits, every `stride` from
+ * generation `start`, to `filename`, or to stdout if it is "-".
+ *
+ * - words are written in the byte order of the machine.
+ */
+bool rng_write(const struct Options* options, const char* filename);
+
+#endif /* RNG_H */
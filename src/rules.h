@@ -0,0 +1,272 @@
+#ifndef RULES_H
+#define RULES_H
+
+/*
+ * Every rule reduced to a minimal expression of its left (`l`), centre (`c`),
+ * and right (`r`) parents using `~`, `&`, `|`, and `^`.
+ *
+ * `ECA_RULES(X)` expands `X(rule, expression)` for each of the 256 rules, so a
+ * kernel can be specialised for every rule. The operands may be any unsigned
+ * type holding one cell per bit, or one cell per byte of all ones or zeros;
+ * only the low bits of the result are meaningful for narrow types.
+ */
+
+#define ECA_RULES(X) \
+	X(  0, 0) \
+	X(  1, ~(l | c | r)) \
+	X(  2, r & ~(l | c)) \
+	X(  3, ~(l | c)) \
+	X(  4, c & ~(l | r)) \
+	X(  5, ~(l | r)) \
+	X(  6, ~l & (c ^ r)) \
+	X(  7, ~(l | (c & r))) \
+	X(  8, c & r & ~l) \
+	X(  9, ~(l | (c ^ r))) \
+	X( 10, r & ~l) \
+	X( 11, ~l & (r | ~c)) \
+	X( 12, c & ~l) \
+	X( 13, ~l & (c | ~r)) \
+	X( 14, ~l & (c | r)) \
+	X( 15, ~l) \
+	X( 16, l & ~(c | r)) \
+	X( 17, ~(c | r)) \
+	X( 18, ~c & (l ^ r)) \
+	X( 19, ~(c | (l & r))) \
+	X( 20, ~r & (l ^ c)) \
+	X( 21, ~(r | (l & c))) \
+	X( 22, (l | c) ^ (r | (l & c))) \
+	X( 23, ~((l & c) | (r & (l | c)))) \
+	X( 24, (l ^ c) & (l ^ r)) \
+	X( 25, c ^ (~r | (l & c))) \
+	X( 26, l ^ (r | (l & c))) \
+	X( 27, (l & r) ^ (r | ~c)) \
+	X( 28, l ^ (c | (l & r))) \
+	X( 29, (l & c) ^ (c | ~r)) \
+	X( 30, l ^ (c | r)) \
+	X( 31, ~(l & (c | r))) \
+	X( 32, l & r & ~c) \
+	X( 33, ~(c | (l ^ r))) \
+	X( 34, r & ~c) \
+	X( 35, ~c & (r | ~l)) \
+	X( 36, (l ^ c) & (c ^ r)) \
+	X( 37, l ^ (~r | (l & c))) \
+	X( 38, c ^ (r | (l & c))) \
+	X( 39, (l | r) ^ (c | ~r)) \
+	X( 40, r & (l ^ c)) \
+	X( 41, (l | c) ^ (~r | (l & c))) \
+	X( 42, r & ~(l & c)) \
+	X( 43, ~(l | c) | (r & (l ^ c))) \
+	X( 44, c ^ (l & (c | r))) \
+	X( 45, l ^ (c | ~r)) \
+	X( 46, (l & c) ^ (c | r)) \
+	X( 47, ~l | (r & ~c)) \
+	X( 48, l & ~c) \
+	X( 49, ~c & (l | ~r)) \
+	X( 50, ~c & (l | r)) \
+	X( 51, ~c) \
+	X( 52, c ^ (l | (c & r))) \
+	X( 53, (l & c) ^ (l | ~r)) \
+	X( 54, c ^ (l | r)) \
+	X( 55, ~(c & (l | r))) \
+	X( 56, l ^ (c & (l | r))) \
+	X( 57, c ^ (l | ~r)) \
+	X( 58, (l & c) ^ (l | r)) \
+	X( 59, ~c | (r & ~l)) \
+	X( 60, l ^ c) \
+	X( 61, l ^ (c | ~(l | r))) \
+	X( 62, l ^ (c | (r & ~l))) \
+	X( 63, ~(l & c)) \
+	X( 64, l & c & ~r) \
+	X( 65, ~(r | (l ^ c))) \
+	X( 66, (l ^ r) & (c ^ r)) \
+	X( 67, l ^ (~c | (l & r))) \
+	X( 68, c & ~r) \
+	X( 69, ~r & (c | ~l)) \
+	X( 70, r ^ (c | (l & r))) \
+	X( 71, (l | c) ^ (r | ~c)) \
+	X( 72, c & (l ^ r)) \
+	X( 73, (l | r) ^ (~c | (l & r))) \
+	X( 74, r ^ (l & (c | r))) \
+	X( 75, l ^ (r | ~c)) \
+	X( 76, c & ~(l & r)) \
+	X( 77, ~(l | r) | (c & (l ^ r))) \
+	X( 78, (l & r) ^ (c | r)) \
+	X( 79, ~l | (c & ~r)) \
+	X( 80, l & ~r) \
+	X( 81, ~r & (l | ~c)) \
+	X( 82, r ^ (l | (c & r))) \
+	X( 83, (l | c) ^ (r | ~l)) \
+	X( 84, ~r & (l | c)) \
+	X( 85, ~r) \
+	X( 86, r ^ (l | c)) \
+	X( 87, ~(r & (l | c))) \
+	X( 88, l ^ (r & (l | c))) \
+	X( 89, r ^ (l | ~c)) \
+	X( 90, l ^ r) \
+	X( 91, l ^ (r | ~(l | c))) \
+	X( 92, (l | c) ^ (l & r)) \
+	X( 93, ~r | (c & ~l)) \
+	X( 94, l ^ (r | (c & ~l))) \
+	X( 95, ~(l & r)) \
+	X( 96, l & (c ^ r)) \
+	X( 97, (c | r) ^ (~l | (c & r))) \
+	X( 98, r ^ (c & (l | r))) \
+	X( 99, c ^ (r | ~l)) \
+	X(100, c ^ (r & (l | c))) \
+	X(101, r ^ (c | ~l)) \
+	X(102, c ^ r) \
+	X(103, c ^ (r | ~(l | c))) \
+	X(104, (l & c) ^ (r & (l | c))) \
+	X(105, l ^ c ^ ~r) \
+	X(106, r ^ (l & c)) \
+	X(107, (l & c) ^ (r | ~(l | c))) \
+	X(108, c ^ (l & r)) \
+	X(109, (l & r) ^ (c | ~(l | r))) \
+	X(110, c ^ (r & (l | ~c))) \
+	X(111, ~l | (c ^ r)) \
+	X(112, l & ~(c & r)) \
+	X(113, ~(c | r) | (l & (c ^ r))) \
+	X(114, (l | r) ^ (c & r)) \
+	X(115, ~c | (l & ~r)) \
+	X(116, (l | c) ^ (c & r)) \
+	X(117, ~r | (l & ~c)) \
+	X(118, c ^ (r | (l & ~c))) \
+	X(119, ~(c & r)) \
+	X(120, l ^ (c & r)) \
+	X(121, (c & r) ^ (l | ~(c | r))) \
+	X(122, l ^ (r & (c | ~l))) \
+	X(123, ~c | (l ^ r)) \
+	X(124, l ^ (c & (r | ~l))) \
+	X(125, ~r | (l ^ c)) \
+	X(126, (l ^ c) | (l ^ r)) \
+	X(127, ~(l & c & r)) \
+	X(128, l & c & r) \
+	X(129, ~((l ^ c) | (l ^ r))) \
+	X(130, r & (l ^ ~c)) \
+	X(131, l ^ (~c | (l & ~r))) \
+	X(132, c & (l ^ ~r)) \
+	X(133, l ^ (~r | (l & ~c))) \
+	X(134, c ^ r ^ (l & (c | r))) \
+	X(135, l ^ ~(c & r)) \
+	X(136, c & r) \
+	X(137, c ^ (~r & (c | ~l))) \
+	X(138, r & (c | ~l)) \
+	X(139, (c & r) | ~(l | c)) \
+	X(140, c & (r | ~l)) \
+	X(141, (c & r) | ~(l | r)) \
+	X(142, (c | r) ^ (l & (c ^ r))) \
+	X(143, ~l | (c & r)) \
+	X(144, l & (c ^ ~r)) \
+	X(145, c ^ (~r | (c & ~l))) \
+	X(146, l ^ r ^ (c & (l | r))) \
+	X(147, c ^ ~(l & r)) \
+	X(148, l ^ c ^ (r & (l | c))) \
+	X(149, r ^ ~(l & c)) \
+	X(150, l ^ c ^ r) \
+	X(151, (l & c) ^ ~(r & (l | c))) \
+	X(152, c ^ (~r & (l | c))) \
+	X(153, c ^ ~r) \
+	X(154, r ^ (l & ~c)) \
+	X(155, c ^ ~(r & (l | c))) \
+	X(156, c ^ (l & ~r)) \
+	X(157, r ^ ~(c & (l | r))) \
+	X(158, (c & r) | (l ^ (c | r))) \
+	X(159, ~(l & (c ^ r))) \
+	X(160, l & r) \
+	X(161, l ^ (~r & (l | ~c))) \
+	X(162, r & (l | ~c)) \
+	X(163, (l & r) | ~(l | c)) \
+	X(164, l ^ (~r & (l | c))) \
+	X(165, l ^ ~r) \
+	X(166, r ^ (c & ~l)) \
+	X(167, l ^ ~(r & (l | c))) \
+	X(168, r & (l | c)) \
+	X(169, r ^ ~(l | c)) \
+	X(170, r) \
+	X(171, r | ~(l | c)) \
+	X(172, c ^ (l & (c ^ r))) \
+	X(173, r ^ ~(l | (c & r))) \
+	X(174, r | (c & ~l)) \
+	X(175, r | ~l) \
+	X(176, l & (r | ~c)) \
+	X(177, (l & r) | ~(c | r)) \
+	X(178, (l | r) ^ (c & (l ^ r))) \
+	X(179, ~c | (l & r)) \
+	X(180, l ^ (c & ~r)) \
+	X(181, r ^ ~(l & (c | r))) \
+	X(182, (l & r) | (c ^ (l | r))) \
+	X(183, ~(c & (l ^ r))) \
+	X(184, l ^ (c & (l ^ r))) \
+	X(185, r ^ ~(c | (l & r))) \
+	X(186, r | (l & ~c)) \
+	X(187, r | ~c) \
+	X(188, (l ^ c) | (l & r)) \
+	X(189, (l ^ c) | (l ^ ~r)) \
+	X(190, r | (l ^ c)) \
+	X(191, r | ~(l & c)) \
+	X(192, l & c) \
+	X(193, l ^ (~c & (l | ~r))) \
+	X(194, l ^ (~c & (l | r))) \
+	X(195, l ^ ~c) \
+	X(196, c & (l | ~r)) \
+	X(197, (l & c) | ~(l | r)) \
+	X(198, c ^ (r & ~l)) \
+	X(199, l ^ ~(c & (l | r))) \
+	X(200, c & (l | r)) \
+	X(201, c ^ ~(l | r)) \
+	X(202, r ^ (l & (c ^ r))) \
+	X(203, c ^ ~(l | (c & r))) \
+	X(204, c) \
+	X(205, c | ~(l | r)) \
+	X(206, c | (r & ~l)) \
+	X(207, c | ~l) \
+	X(208, l & (c | ~r)) \
+	X(209, (l & c) | ~(c | r)) \
+	X(210, l ^ (r & ~c)) \
+	X(211, c ^ ~(l & (c | r))) \
+	X(212, (l | c) ^ (r & (l ^ c))) \
+	X(213, ~r | (l & c)) \
+	X(214, (l & c) | (r ^ (l | c))) \
+	X(215, ~(r & (l ^ c))) \
+	X(216, l ^ (r & (l ^ c))) \
+	X(217, c ^ ~(r | (l & c))) \
+	X(218, (l & c) | (l ^ r)) \
+	X(219, (l ^ r) | (l ^ ~c)) \
+	X(220, c | (l & ~r)) \
+	X(221, c | ~r) \
+	X(222, c | (l ^ r)) \
+	X(223, c | ~(l & r)) \
+	X(224, l & (c | r)) \
+	X(225, l ^ ~(c | r)) \
+	X(226, r ^ (c & (l ^ r))) \
+	X(227, l ^ ~(c | (l & r))) \
+	X(228, c ^ (r & (l ^ c))) \
+	X(229, l ^ ~(r | (l & c))) \
+	X(230, (l & c) | (c ^ r)) \
+	X(231, (c ^ r) | (l ^ ~c)) \
+	X(232, (l & c) | (r & (l | c))) \
+	X(233, (l & c) | (r ^ ~(l | c))) \
+	X(234, r | (l & c)) \
+	X(235, r | (l ^ ~c)) \
+	X(236, c | (l & r)) \
+	X(237, c | (l ^ ~r)) \
+	X(238, c | r) \
+	X(239, c | r | ~l) \
+	X(240, l) \
+	X(241, l | ~(c | r)) \
+	X(242, l | (r & ~c)) \
+	X(243, l | ~c) \
+	X(244, l | (c & ~r)) \
+	X(245, l | ~r) \
+	X(246, l | (c ^ r)) \
+	X(247, l | ~(c & r)) \
+	X(248, l | (c & r)) \
+	X(249, l | (c ^ ~r)) \
+	X(250, l | r) \
+	X(251, l | r | ~c) \
+	X(252, l | c) \
+	X(253, l | c | ~r) \
+	X(254, l | c | r) \
+	X(255, ~0)
+
+#endif /* RULES_H */
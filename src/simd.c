@@ -0,0 +1,269 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "simd.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+/*
+ * Scalar versions of the kernels working on a range of bytes rather than
+ * whole cells, these cover the wrap-around edges and whatever remains of a
+ * row after the vectorised loop.
+ *
+ * - `size` is the size of the row in bytes, there must be 3 channels.
+ */
+static void standard_bytes(
+	uint8_t* dst, const uint8_t* src, size_t size, uint8_t rule,
+	size_t first, size_t last
+) {
+	for (size_t j = first; j < last; ++j) {
+		uint8_t rule_index = 0;
+		if (src[(j + size - 3) % size] == ECA_ON) {
+			rule_index |= 4;
+		}
+		if (src[j] == ECA_ON) {
+			rule_index |= 2;
+		}
+		if (src[(j + 3) % size] == ECA_ON) {
+			rule_index |= 1;
+		}
+
+		if ((rule >> rule_index) & 1) {
+			dst[j] = ECA_ON;
+		}
+	}
+}
+
+static void split_bytes(
+	uint8_t* dst, const uint8_t* src, size_t size, uint8_t rules[3],
+	size_t first, size_t last
+) {
+	for (size_t j = first; j < last; ++j) {
+		uint8_t rule_index = 0;
+		if (src[(j + size - 3) % size] == ECA_ON) {
+			rule_index |= 4;
+		}
+		if (src[j] == ECA_ON) {
+			rule_index |= 2;
+		}
+		if (src[(j + 3) % size] == ECA_ON) {
+			rule_index |= 1;
+		}
+
+		bool fill_pixel = (rules[j % 3] >> rule_index) & 1;
+		dst[j] = fill_pixel ? ECA_ON : ECA_OFF;
+	}
+}
+
+static bool cell_set(const uint8_t* src, size_t pixel_index) {
+	return src[pixel_index] != ECA_OFF
+	    || src[pixel_index + 1] != ECA_OFF
+	    || src[pixel_index + 2] != ECA_OFF;
+}
+
+static void directional_bytes(
+	uint8_t* dst, const uint8_t* src, size_t size, uint8_t rule,
+	size_t first, size_t last
+) {
+	for (size_t j = first; j < last; ++j) {
+		size_t pixel_index = j - (j % 3);
+		bool parents[3] = {
+			cell_set(src, (pixel_index + size - 3) % size),
+			cell_set(src, pixel_index),
+			cell_set(src, (pixel_index + 3) % size)
+		};
+
+		uint8_t rule_index = (parents[0] << 2)
+		                   | (parents[1] << 1)
+		                   | (parents[2]);
+
+		if ((rule >> rule_index) & 1) {
+			dst[j] = parents[j % 3] ? ECA_ON : ECA_HALF;
+		}
+	}
+}
+
+#ifdef SIMD_X86
+
+/* `channel_masks[phase][channel]` selects the lanes of a channel */
+static uint8_t channel_masks[3][3][64];
+
+/* ssse3: 16 bytes per vector, the shuffle requires ssse3 rather than sse2 */
+#define KERNEL       __attribute__((target("ssse3")))
+#define NAME(x)      x##_ssse3
+#define VEC          __m128i
+#define WIDTH        16
+#define LOADU(p)     _mm_loadu_si128((const __m128i*)(p))
+#define STOREU(p, v) _mm_storeu_si128((__m128i*)(p), (v))
+#define SET1(x)      _mm_set1_epi8((char)(x))
+#define EQ(a, b)     _mm_cmpeq_epi8((a), (b))
+#define AND(a, b)    _mm_and_si128((a), (b))
+#define OR(a, b)     _mm_or_si128((a), (b))
+#define ANDNOT(a, b) _mm_andnot_si128((a), (b))
+#define SHUF(t, i)   _mm_shuffle_epi8((t), (i))
+#define TABLE(p)     LOADU(p)
+#include "simd_kernel.h"
+#undef KERNEL
+#undef NAME
+#undef VEC
+#undef WIDTH
+#undef LOADU
+#undef STOREU
+#undef SET1
+#undef EQ
+#undef AND
+#undef OR
+#undef ANDNOT
+#undef SHUF
+#undef TABLE
+
+/* avx2: 32 bytes per vector, the table is repeated in each 128 bit lane */
+#define KERNEL       __attribute__((target("avx2")))
+#define NAME(x)      x##_avx2
+#define VEC          __m256i
+#define WIDTH        32
+#define LOADU(p)     _mm256_loadu_si256((const __m256i*)(p))
+#define STOREU(p, v) _mm256_storeu_si256((__m256i*)(p), (v))
+#define SET1(x)      _mm256_set1_epi8((char)(x))
+#define EQ(a, b)     _mm256_cmpeq_epi8((a), (b))
+#define AND(a, b)    _mm256_and_si256((a), (b))
+#define OR(a, b)     _mm256_or_si256((a), (b))
+#define ANDNOT(a, b) _mm256_andnot_si256((a), (b))
+#define SHUF(t, i)   _mm256_shuffle_epi8((t), (i))
+#define TABLE(p)     _mm256_broadcastsi128_si256( \
+	_mm_loadu_si128((const __m128i*)(p)))
+#include "simd_kernel.h"
+#undef KERNEL
+#undef NAME
+#undef VEC
+#undef WIDTH
+#undef LOADU
+#undef STOREU
+#undef SET1
+#undef EQ
+#undef AND
+#undef OR
+#undef ANDNOT
+#undef SHUF
+#undef TABLE
+
+/* avx512: 64 bytes per vector, byte operations require avx512bw */
+#define KERNEL       __attribute__((target("avx512f,avx512bw")))
+#define NAME(x)      x##_avx512
+#define VEC          __m512i
+#define WIDTH        64
+#define LOADU(p)     _mm512_loadu_si512((const void*)(p))
+#define STOREU(p, v) _mm512_storeu_si512((void*)(p), (v))
+#define SET1(x)      _mm512_set1_epi8((char)(x))
+#define EQ(a, b)     _mm512_movm_epi8(_mm512_cmpeq_epi8_mask((a), (b)))
+#define AND(a, b)    _mm512_and_si512((a), (b))
+#define OR(a, b)     _mm512_or_si512((a), (b))
+#define ANDNOT(a, b) _mm512_andnot_si512((a), (b))
+#define SHUF(t, i)   _mm512_shuffle_epi8((t), (i))
+#define TABLE(p)     _mm512_broadcast_i32x4( \
+	_mm_loadu_si128((const __m128i*)(p)))
+#include "simd_kernel.h"
+#undef KERNEL
+#undef NAME
+#undef VEC
+#undef WIDTH
+#undef LOADU
+#undef STOREU
+#undef SET1
+#undef EQ
+#undef AND
+#undef OR
+#undef ANDNOT
+#undef SHUF
+#undef TABLE
+
+#endif /* SIMD_X86 */
+
+enum Isa {
+	ISA_UNKNOWN = 0,
+	ISA_SCALAR,
+	ISA_SSSE3,
+	ISA_AVX2,
+	ISA_AVX512
+};
+
+/* detected once, by whichever thread selects a kernel first */
+static enum Isa isa = ISA_UNKNOWN;
+static pthread_once_t isa_once = PTHREAD_ONCE_INIT;
+
+static void detect_isa(void) {
+	isa = ISA_SCALAR;
+
+#ifdef SIMD_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512bw")) {
+		isa = ISA_AVX512;
+	} else if (__builtin_cpu_supports("avx2")) {
+		isa = ISA_AVX2;
+	} else if (__builtin_cpu_supports("ssse3")) {
+		isa = ISA_SSSE3;
+	}
+
+	for (int phase = 0; phase < 3; ++phase) {
+		for (int channel = 0; channel < 3; ++channel) {
+			for (int i = 0; i < 64; ++i) {
+				bool match = (phase + i) % 3 == channel;
+				channel_masks[phase][channel][i] = \
+					match ? 0xff : 0x00;
+			}
+		}
+	}
+#endif
+}
+
+eca_gen_fn* eca_simd_select(eca_gen_fn* gen_fn) {
+	pthread_once(&isa_once, detect_isa);
+
+#ifdef SIMD_X86
+	if (gen_fn == eca_generate) {
+		switch (isa) {
+			case ISA_AVX512: return generate_avx512;
+			case ISA_AVX2:   return generate_avx2;
+			case ISA_SSSE3:  return generate_ssse3;
+			default:         break;
+		}
+	}
+
+	if (gen_fn == eca_generate_split) {
+		switch (isa) {
+			case ISA_AVX512: return generate_split_avx512;
+			case ISA_AVX2:   return generate_split_avx2;
+			case ISA_SSSE3:  return generate_split_ssse3;
+			default:         break;
+		}
+	}
+
+	if (gen_fn == eca_generate_directional) {
+		switch (isa) {
+			case ISA_AVX512: return generate_directional_avx512;
+			case ISA_AVX2:   return generate_directional_avx2;
+			case ISA_SSSE3:  return generate_directional_ssse3;
+			default:         break;
+		}
+	}
+#endif
+
+	return gen_fn;
+}
+
+const char* eca_simd_name(void) {
+	pthread_once(&isa_once, detect_isa);
+
+	switch (isa) {
+		case ISA_SSSE3:  return "ssse3";
+		case ISA_AVX2:   return "avx2";
+		case ISA_AVX512: return "avx512";
+		default:         return "scalar";
+	}
+}
@@ -0,0 +1,21 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include "eca.h"
+
+/**
+ * Returns the widest vectorised equivalent of a byte layout kernel which is
+ * supported by the CPU, or `gen_fn` itself if there is none.
+ *
+ * - the CPU is queried on the first call.
+ * - the vectorised kernels expect every channel of a cell to be equal in
+ *   standard mode, as written by the `eca_initialise*` functions.
+ */
+eca_gen_fn* eca_simd_select(eca_gen_fn* gen_fn);
+
+/**
+ * The name of the instruction set used by `eca_simd_select`.
+ */
+const char* eca_simd_name(void);
+
+#endif /* SIMD_H */
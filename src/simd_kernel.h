@@ -0,0 +1,197 @@
+/*
+ * Vectorised byte layout kernels, included once per instruction set by
+ * `simd.c`. The including file defines:
+ *
+ * - `KERNEL`         function attributes enabling the instruction set.
+ * - `NAME(x)`        the suffixed name of a function.
+ * - `VEC`, `WIDTH`   the vector type and its width in bytes.
+ * - `LOADU`, `STOREU`, `SET1`, `EQ`, `AND`, `OR`, `ANDNOT`, `SHUF`, `TABLE`
+ *
+ * Each kernel works on the interleaved RGB bytes directly; the same channel
+ * of the left and right cells are always 3 bytes away. Vectors cover bytes
+ * `[6, end)`, the remainder of the row is left to the scalar byte functions.
+ */
+
+/* returns the end of the range which was generated */
+KERNEL static size_t NAME(standard)(
+	uint8_t* dst, const uint8_t* src, size_t size, uint8_t rule
+) {
+	uint8_t table[16];
+	for (int i = 0; i < 16; ++i) {
+		table[i] = ((rule >> (i % 8)) & 1) ? 0xff : 0x00;
+	}
+
+	VEC tab = TABLE(table);
+	VEC on  = SET1(ECA_ON);
+	VEC b4  = SET1(4);
+	VEC b2  = SET1(2);
+	VEC b1  = SET1(1);
+
+	size_t j = 6;
+	for (; j + WIDTH + 3 <= size; j += WIDTH) {
+		VEC l = EQ(LOADU(src + j - 3), on);
+		VEC c = EQ(LOADU(src + j), on);
+		VEC r = EQ(LOADU(src + j + 3), on);
+
+		VEC index = OR(OR(AND(l, b4), AND(c, b2)), AND(r, b1));
+		VEC fill = SHUF(tab, index);
+
+		VEC old = LOADU(dst + j);
+		STOREU(dst + j, OR(AND(fill, on), ANDNOT(fill, old)));
+	}
+
+	return j;
+}
+
+KERNEL static size_t NAME(split)(
+	uint8_t* dst, const uint8_t* src, size_t size, uint8_t rules[3]
+) {
+	/* red and green share a table, the green half is selected by bit 3 */
+	uint8_t table_rg[16];
+	uint8_t table_b[16];
+	for (int i = 0; i < 16; ++i) {
+		uint8_t rule = (i < 8) ? rules[0] : rules[1];
+		table_rg[i] = ((rule >> (i % 8)) & 1) ? 0xff : 0x00;
+		table_b[i] = ((rules[2] >> (i % 8)) & 1) ? 0xff : 0x00;
+	}
+
+	VEC tab_rg = TABLE(table_rg);
+	VEC tab_b  = TABLE(table_b);
+	VEC on  = SET1(ECA_ON);
+	VEC off = SET1(ECA_OFF);
+	VEC b8  = SET1(8);
+	VEC b4  = SET1(4);
+	VEC b2  = SET1(2);
+	VEC b1  = SET1(1);
+
+	size_t j = 6;
+	int phase = 0;
+	for (; j + WIDTH + 3 <= size; j += WIDTH) {
+		VEC green = LOADU(channel_masks[phase][1]);
+		VEC blue  = LOADU(channel_masks[phase][2]);
+
+		VEC l = EQ(LOADU(src + j - 3), on);
+		VEC c = EQ(LOADU(src + j), on);
+		VEC r = EQ(LOADU(src + j + 3), on);
+
+		VEC index = OR(OR(AND(l, b4), AND(c, b2)), AND(r, b1));
+		VEC fill = OR(
+			AND(blue, SHUF(tab_b, index)),
+			ANDNOT(blue, SHUF(tab_rg, OR(index, AND(green, b8))))
+		);
+
+		STOREU(dst + j, OR(AND(fill, on), ANDNOT(fill, off)));
+		phase = (phase + WIDTH) % 3;
+	}
+
+	return j;
+}
+
+/*
+ * Lanes where no byte of the cell starting at `p - channel` is activated,
+ * `z[n]` compares the bytes at `p + n - 2` with `ECA_OFF`.
+ */
+#define CELL_OFF(z, red, green, blue) \
+	OR(OR( \
+		AND(red,   AND(AND(z[2], z[3]), z[4])), \
+		AND(green, AND(AND(z[1], z[2]), z[3]))), \
+		AND(blue,  AND(AND(z[0], z[1]), z[2])) \
+	)
+
+KERNEL static size_t NAME(directional)(
+	uint8_t* dst, const uint8_t* src, size_t size, uint8_t rule
+) {
+	uint8_t table[16];
+	for (int i = 0; i < 16; ++i) {
+		table[i] = ((rule >> (i % 8)) & 1) ? 0xff : 0x00;
+	}
+
+	VEC tab  = TABLE(table);
+	VEC on   = SET1(ECA_ON);
+	VEC off  = SET1(ECA_OFF);
+	VEC half = SET1(ECA_HALF);
+	VEC ones = SET1(0xff);
+	VEC b4   = SET1(4);
+	VEC b2   = SET1(2);
+	VEC b1   = SET1(1);
+
+	size_t j = 6;
+	int phase = 0;
+	for (; j + WIDTH + 5 <= size; j += WIDTH) {
+		VEC red   = LOADU(channel_masks[phase][0]);
+		VEC green = LOADU(channel_masks[phase][1]);
+		VEC blue  = LOADU(channel_masks[phase][2]);
+
+		/* bytes j - 5 to j + 5 */
+		VEC z[11];
+		for (int n = 0; n < 11; ++n) {
+			z[n] = EQ(LOADU(src + j + n - 5), off);
+		}
+
+		VEC l = ANDNOT(CELL_OFF((z + 0), red, green, blue), ones);
+		VEC c = ANDNOT(CELL_OFF((z + 3), red, green, blue), ones);
+		VEC r = ANDNOT(CELL_OFF((z + 6), red, green, blue), ones);
+
+		VEC index = OR(OR(AND(l, b4), AND(c, b2)), AND(r, b1));
+		VEC fill = SHUF(tab, index);
+
+		VEC parent = OR(OR(AND(red, l), AND(green, c)), AND(blue, r));
+		VEC colour = OR(AND(parent, on), ANDNOT(parent, half));
+
+		VEC old = LOADU(dst + j);
+		STOREU(dst + j, OR(AND(fill, colour), ANDNOT(fill, old)));
+		phase = (phase + WIDTH) % 3;
+	}
+
+	return j;
+}
+
+#undef CELL_OFF
+
+static void NAME(generate)(
+	uint8_t* dst, const uint8_t* src, size_t width, int channel_count,
+	uint8_t rules[channel_count]
+) {
+	if (channel_count != 3) {
+		eca_generate(dst, src, width, channel_count, rules);
+		return;
+	}
+
+	size_t size = width * 3;
+	size_t head = (size < 6) ? size : 6;
+	size_t end = NAME(standard)(dst, src, size, rules[0]);
+	standard_bytes(dst, src, size, rules[0], 0, head);
+	standard_bytes(dst, src, size, rules[0], end, size);
+}
+
+static void NAME(generate_split)(
+	uint8_t* dst, const uint8_t* src, size_t width, int channel_count,
+	uint8_t rules[channel_count]
+) {
+	if (channel_count != 3) {
+		eca_generate_split(dst, src, width, channel_count, rules);
+		return;
+	}
+
+	size_t size = width * 3;
+	size_t head = (size < 6) ? size : 6;
+	size_t end = NAME(split)(dst, src, size, rules);
+	split_bytes(dst, src, size, rules, 0, head);
+	split_bytes(dst, src, size, rules, end, size);
+}
+
+static void NAME(generate_directional)(
+	uint8_t* dst, const uint8_t* src, size_t width, int channel_count,
+	uint8_t rules[channel_count]
+) {
+	if (channel_count != 3) {
+		eca_generate_directional(dst, src, width, channel_count, rules);
+		return;
+	}
+
+	size_t size = width * 3;
+	size_t head = (size < 6) ? size : 6;
+	size_t end = NAME(directional)(dst, src, size, rules[0]);
+	directional_bytes(dst, src, size, rules[0], 0, head);
+	directional_bytes(dst, src, size, rules[0], end, size);
+}
@@ -0,0 +1,127 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "stats.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <time.h>
+
+static const char* phase_names[] = {
+	"initialise",
+	"generate",
+	"encode",
+	"window",
+	"upload"
+};
+
+static const char* counter_names[] = {
+	"images",
+	"rows",
+	"cells",
+	"bytes_written",
+	"display_buffer_bytes",
+	"cycles",
+	"transient",
+	"period",
+	"hashlife_nodes",
+	"hashlife_memoised",
+	"hashlife_memory_bytes",
+	"hashlife_hits",
+	"hashlife_misses",
+	"hashlife_collections"
+};
+
+static bool enabled = false;
+static uint64_t started = 0;
+static uint64_t phase_ns[STATS_LAST];
+static uint64_t counters[STATS_COUNTER_LAST];
+
+static uint64_t clock_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+static void print_report(void) {
+	double total = (clock_ns() - started) * 1e-9;
+
+	/* the largest resident size of the process, in KiB on linux */
+	struct rusage usage;
+	long peak = 0;
+	if (getrusage(RUSAGE_SELF, &usage) == 0) {
+		peak = usage.ru_maxrss;
+	}
+
+	fprintf(stderr, "{\"seconds\": {\"total\": %.6f", total);
+	for (int phase = 0; phase < STATS_LAST; ++phase) {
+		fprintf(
+			stderr, ", \"%s\": %.6f",
+			phase_names[phase], phase_ns[phase] * 1e-9
+		);
+	}
+	fprintf(stderr, "}");
+
+	for (int counter = 0; counter < STATS_COUNTER_LAST; ++counter) {
+		fprintf(
+			stderr, ", \"%s\": %llu",
+			counter_names[counter], (unsigned long long)counters[counter]
+		);
+	}
+	fprintf(stderr, ", \"peak_memory_bytes\": %lld}\n", peak * 1024LL);
+}
+
+bool stats_enable(void) {
+	if (enabled) {
+		return true;
+	}
+
+	enabled = true;
+	started = clock_ns();
+
+	return atexit(print_report) == 0;
+}
+
+bool stats_enabled(void) {
+	return enabled;
+}
+
+uint64_t stats_clock(void) {
+	return enabled ? clock_ns() : 0;
+}
+
+void stats_end(enum StatsPhase phase, uint64_t begin) {
+	if (enabled) {
+		stats_add(phase, clock_ns() - begin);
+	}
+}
+
+void stats_add(enum StatsPhase phase, uint64_t nanoseconds) {
+	if (enabled) {
+		__atomic_fetch_add(&phase_ns[phase], nanoseconds, __ATOMIC_RELAXED);
+	}
+}
+
+void stats_count(enum StatsCounter counter, uint64_t amount) {
+	if (enabled) {
+		__atomic_fetch_add(&counters[counter], amount, __ATOMIC_RELAXED);
+	}
+}
+
+void stats_max(enum StatsCounter counter, uint64_t value) {
+	if (!enabled) {
+		return;
+	}
+
+	uint64_t seen = __atomic_load_n(&counters[counter], __ATOMIC_RELAXED);
+	while (
+		seen < value
+		&& !__atomic_compare_exchange_n(
+			&counters[counter], &seen, value, true,
+			__ATOMIC_RELAXED, __ATOMIC_RELAXED
+		)
+	) {
+		/* a failed exchange reloads `seen` */
+	}
+}
@@ -0,0 +1,72 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Timings and counters of a run, reported as JSON on stderr with `--stats`.
+ *
+ * Everything is off until `stats_enable` is called, and each call below then
+ * returns straight away, so the phases are cheap to leave instrumented. The
+ * counters are shared by every thread of a batch, and each phase is the sum
+ * of its time on every thread.
+ */
+
+enum StatsPhase {
+	STATS_INITIALISE = 0, /* populating the first generation */
+	STATS_GENERATE   = 1, /* later generations, and colouring them */
+	STATS_ENCODE     = 2, /* filtering, deflating, and writing the png */
+	STATS_WINDOW     = 3, /* creating the window and loading OpenGL */
+	STATS_UPLOAD     = 4, /* uploading the image as a texture */
+	STATS_LAST       = 5
+};
+
+enum StatsCounter {
+	STATS_IMAGES               = 0,  /* png files written */
+	STATS_ROWS                 = 1,  /* png rows written */
+	STATS_CELLS                = 2,  /* cells times generations advanced */
+	STATS_BYTES_WRITTEN        = 3,  /* bytes of png written */
+	STATS_DISPLAY_BUFFER       = 4,  /* bytes of the image kept for display */
+	STATS_CYCLES               = 5,  /* images whose rows cycled */
+	STATS_TRANSIENT            = 6,  /* longest generations before a cycle */
+	STATS_PERIOD               = 7,  /* longest period of a cycle */
+	STATS_HASHLIFE_NODES       = 8,  /* most blocks stored by hashlife */
+	STATS_HASHLIFE_MEMO        = 9,  /* most results memoised */
+	STATS_HASHLIFE_BYTES       = 10, /* most bytes used by the tables */
+	STATS_HASHLIFE_HITS        = 11, /* results found in the memo */
+	STATS_HASHLIFE_MISSES      = 12, /* results computed */
+	STATS_HASHLIFE_COLLECTIONS = 13, /* tables emptied to fit the limit */
+	STATS_COUNTER_LAST         = 14
+};
+
+/**
+ * Starts collecting, and prints the report when the program exits.
+ *
+ * - returns false if the report could not be registered to print.
+ */
+bool stats_enable(void);
+
+bool stats_enabled(void);
+
+/**
+ * The current time in nanoseconds, or 0 when not collecting.
+ *
+ * - pass the time a phase began to `stats_end` when it ends.
+ */
+uint64_t stats_clock(void);
+
+void stats_end(enum StatsPhase phase, uint64_t begin);
+
+void stats_add(enum StatsPhase phase, uint64_t nanoseconds);
+
+void stats_count(enum StatsCounter counter, uint64_t amount);
+
+/**
+ * Raises `counter` to `value`, for counters which report the largest of
+ * each image of a batch rather than their sum.
+ */
+void stats_max(enum StatsCounter counter, uint64_t value);
+
+#endif /* STATS_H */
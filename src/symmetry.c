@@ -0,0 +1,80 @@
+#include "symmetry.h"
+
+#include "eca.h"
+#include "packed.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+uint8_t symmetry_canonical(
+	const struct Options* options, enum Symmetry* symmetry
+) {
+	uint8_t rule = options->rules[0];
+	*symmetry = SYMMETRY_NONE;
+
+	if (options->mode != MODE_STANDARD) {
+		return rule;
+	}
+
+	bool mirror = options->initial == INIT_STANDARD
+	           || options->initial == INIT_ALTERNATE;
+	bool complement = options->initial == INIT_ALTERNATE
+	               && options->width % 2 == 0;
+
+	uint8_t canonical = rule;
+	for (int s = SYMMETRY_MIRROR; s <= SYMMETRY_BOTH; ++s) {
+		if (
+			((s & SYMMETRY_MIRROR) && !mirror)
+			|| ((s & SYMMETRY_COMPLEMENT) && !complement)
+		) {
+			continue;
+		}
+
+		/* each symmetry is its own inverse */
+		uint8_t related = rule;
+		if (s & SYMMETRY_MIRROR) {
+			related = get_mirror_rule(related);
+		}
+		if (s & SYMMETRY_COMPLEMENT) {
+			related = get_complement_rule(related);
+		}
+
+		if (related < canonical) {
+			canonical = related;
+			*symmetry = s;
+		}
+	}
+
+	return canonical;
+}
+
+void symmetry_apply(
+	uint64_t* dst, const uint8_t* src, size_t width, enum Symmetry symmetry
+) {
+	memset(dst, 0, eca_packed_words(width) * sizeof(*dst));
+
+	/* the mono format of the standard palette is set for inactive cells */
+	uint8_t invert = (symmetry & SYMMETRY_COMPLEMENT) ? 0 : 1;
+
+	/* mirrored about the centre cell, and shifted back when inverted */
+	size_t axis = (width % 2 == 0) ? 0 : width - 1;
+	size_t shift = (symmetry & SYMMETRY_COMPLEMENT) ? 1 : 0;
+	bool mirror = (symmetry & SYMMETRY_MIRROR) != 0;
+
+	/* the source of cell 0, which then steps one cell each way */
+	size_t q = (width - shift) % width;
+	if (mirror) {
+		q = (axis + width - q) % width;
+	}
+
+	for (size_t p = 0; p < width; ++p) {
+		uint64_t cell = ((src[q / 8] >> (7 - (q % 8))) & 1) ^ invert;
+		dst[p / 64] |= cell << (p % 64);
+
+		if (mirror) {
+			q = (q == 0) ? width - 1 : q - 1;
+		} else {
+			q = (q + 1 == width) ? 0 : q + 1;
+		}
+	}
+}
@@ -0,0 +1,49 @@
+#ifndef SYMMETRY_H
+#define SYMMETRY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "options.h"
+
+/*
+ * Rules related by a mirror (`get_mirror_rule`) or complement
+ * (`get_complement_rule`) draw the same image, flipped or inverted, from a
+ * matching initial generation. Of the 256 rules, only 88 differ once these
+ * are taken into account.
+ *
+ * A symmetry can only be used when the initial generation is unchanged by it,
+ * on the wrapping row, up to a rotation:
+ *
+ * - standard and alternate are mirrored in place, about the centre cell.
+ * - alternate rows of an even width, inverted, are the same row shifted by
+ *   one cell.
+ * - random rows have no symmetry.
+ */
+
+enum Symmetry {
+	SYMMETRY_NONE       = 0,
+	SYMMETRY_MIRROR     = 1,
+	SYMMETRY_COMPLEMENT = 2,
+	SYMMETRY_BOTH       = 3
+};
+
+/**
+ * The lowest rule equivalent to `options->rules[0]` from the same initial
+ * generation, and the symmetry which derives the image of the rule from it.
+ *
+ * - only standard mode is reduced, other modes return the rule unchanged.
+ */
+uint8_t symmetry_canonical(
+	const struct Options* options, enum Symmetry* symmetry
+);
+
+/**
+ * Applies a symmetry to a row of the canonical rule's image, in the mono
+ * format of the standard palette, giving the packed row of the rule's image.
+ */
+void symmetry_apply(
+	uint64_t* dst, const uint8_t* src, size_t width, enum Symmetry symmetry
+);
+
+#endif /* SYMMETRY_H */